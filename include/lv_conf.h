@@ -32,15 +32,53 @@
 #define LV_USE_XML 1
 #define LV_USE_DRAW_SW_COMPLEX_GRADIENTS 1
 
+/* Widget names from XML, used to look up data channel targets */
+#define LV_USE_OBJ_NAME 1
+#define LV_USE_OBSERVER 1
+
 #define LV_USE_LODEPNG 1
 #define LV_USE_FS_IF        1
 #define LV_FS_IF_LITTLEFS  'S'    // choose the letter you want to use
 
+/* LVGL's messages go through LVML's deferred log (lvmlLogLvgl). Trace and
+ * info messages are compiled out: they fire on every redraw. */
 #define LV_USE_LOG      1
-#define LV_LOG_LEVEL    LV_LOG_LEVEL_TRACE
+#define LV_LOG_LEVEL    LV_LOG_LEVEL_WARN
+
 
+/* LVGL's heap: a TLSF pool of LVML_LV_MEM_SIZE bytes taken from PSRAM
+ * (or internal RAM with LVML_LV_MEM_PSRAM 0) when LVGL starts, so widget
+ * heavy screens cannot starve WiFi of internal RAM and the pool keeps its
+ * own counters (lvmlLvglHeapStats()). LVML_LV_MEM_POOL 0 goes back to the
+ * C library's malloc.
+ *
+ * PNGs are decoded into this pool when drawn: lodepng's 32-bit pixels and the
+ * ARGB8888 draw buffer they are copied into, w * h * 4 bytes each. A full
+ * 320x240 screen image takes 2 * 307200 bytes on top of the widgets, so the
+ * pool is sized for that with room to spare (the ESP32-S3-BOX-3 has 16 MB of
+ * PSRAM). loadImage() warns when an image will not fit. */
+#ifndef LVML_LV_MEM_POOL
+#define LVML_LV_MEM_POOL 1
+#endif
+#ifndef LVML_LV_MEM_SIZE
+#define LVML_LV_MEM_SIZE (2 * 1024 * 1024)
+#endif
+#ifndef LVML_LV_MEM_PSRAM
+#define LVML_LV_MEM_PSRAM 1
+#endif
 
+#if LVML_LV_MEM_POOL
+#define LV_USE_STDLIB_MALLOC  LV_STDLIB_BUILTIN
+#define LV_MEM_SIZE           LVML_LV_MEM_SIZE
+#define LV_MEM_POOL_INCLUDE   <esp_heap_caps.h>
+#if LVML_LV_MEM_PSRAM
+#define LV_MEM_POOL_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+#else
+#define LV_MEM_POOL_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+#endif
+#else
 #define LV_USE_STDLIB_MALLOC  LV_STDLIB_CLIB
+#endif
 #define LV_USE_STDLIB_STRING  LV_STDLIB_CLIB
 #define LV_USE_STDLIB_SPRINTF LV_STDLIB_CLIB
 
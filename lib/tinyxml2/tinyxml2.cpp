@@ -32,6 +32,28 @@ distribution.
 #   include <cstdarg>
 #endif
 
+/*
+	Byte scanners for the parser's and printer's inner loops. With SSE2 they
+	test 16 bytes at a time; other GCC-compatible little-endian targets (the
+	ESP32 among them) test a machine word at a time (SWAR). Both use aligned
+	loads, which never cross into another page, and so may read past the
+	terminating NUL within the last block. Define TINYXML2_NO_SIMD for the
+	plain byte loops, or TINYXML2_SWAR to use the word path on x86.
+*/
+#if !defined(TINYXML2_NO_SIMD) && defined(__GNUC__)
+#   if defined(__SSE2__) && !defined(TINYXML2_SWAR)
+#       define TIXML_SCAN_SSE2
+#       include <emmintrin.h>
+#   elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#       define TIXML_SCAN_SWAR
+#   endif
+#   if defined(__clang__) || __GNUC__ >= 8
+#       define TIXML_SCAN_FUNCTION __attribute__((no_sanitize_address))
+#   else
+#       define TIXML_SCAN_FUNCTION
+#   endif
+#endif
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1400 ) && (!defined WINCE)
 	// Microsoft Visual Studio, version 2005 and higher. Not WinCE.
 	/*int _snprintf_s(
@@ -133,6 +155,383 @@ static const unsigned char TIXML_UTF_LEAD_2 = 0xbfU;
 namespace tinyxml2
 {
 
+class XMLHeapAllocator : public XMLAllocator
+{
+public:
+    virtual void* Allocate( size_t size ) override {
+        void* mem = malloc( size );
+        // Callers rely on Allocate() never returning null
+        if ( !mem ) {
+            abort();
+        }
+        return mem;
+    }
+    virtual void Deallocate( void* mem ) override {
+        free( mem );
+    }
+};
+
+XMLAllocator* XMLAllocator::Heap()
+{
+    // Never destroyed, so documents with static storage can still free
+    static XMLAllocator* heap = new XMLHeapAllocator();
+    return heap;
+}
+
+
+XMLNameTable::XMLNameTable( XMLAllocator* allocator ) :
+    _allocator( allocator ),
+    _slots( 0 ),
+    _capacity( 0 ),
+    _count( 0 ),
+    _chunks( 0 )
+{
+}
+
+
+XMLNameTable::~XMLNameTable()
+{
+    while ( _chunks ) {
+        Chunk* next = _chunks->next;
+        _allocator->Deallocate( _chunks );
+        _chunks = next;
+    }
+    if ( _slots ) {
+        _allocator->Deallocate( _slots );
+    }
+}
+
+
+const XMLNameTable::Slot* XMLNameTable::FindSlot( const char* name, size_t length, uint32_t hash ) const
+{
+    const size_t mask = _capacity - 1;
+    for ( size_t i = hash & mask; ; i = (i + 1) & mask ) {
+        const Slot* slot = &_slots[i];
+        if ( !slot->name || ( slot->hash == hash && slot->length == length && memcmp( slot->name, name, length ) == 0 ) ) {
+            return slot;
+        }
+    }
+}
+
+
+void XMLNameTable::Grow()
+{
+    // Power of two, at most half full
+    Slot* oldSlots = _slots;
+    const size_t oldCapacity = _capacity;
+    _capacity = oldCapacity ? oldCapacity * 2 : 64;
+    _slots = static_cast<Slot*>( _allocator->Allocate( sizeof( Slot ) * _capacity ) );
+    memset( _slots, 0, sizeof( Slot ) * _capacity );
+    for ( size_t i = 0; i < oldCapacity; ++i ) {
+        if ( oldSlots[i].name ) {
+            *const_cast<Slot*>( FindSlot( oldSlots[i].name, oldSlots[i].length, oldSlots[i].hash ) ) = oldSlots[i];
+        }
+    }
+    if ( oldSlots ) {
+        _allocator->Deallocate( oldSlots );
+    }
+}
+
+
+const char* XMLNameTable::Intern( const char* name, size_t length )
+{
+    if ( ( _count + 1 ) * 2 > _capacity ) {
+        Grow();
+    }
+    const uint32_t hash = XMLUtil::HashName( name, length );
+    Slot* slot = const_cast<Slot*>( FindSlot( name, length, hash ) );
+    if ( slot->name ) {
+        return slot->name;
+    }
+
+    if ( !_chunks || _chunks->size - _chunks->used < length + 1 ) {
+        const size_t size = length + 1 > 1024 ? length + 1 : 1024;
+        Chunk* chunk = static_cast<Chunk*>( _allocator->Allocate( sizeof( Chunk ) + size ) );
+        chunk->next = _chunks;
+        chunk->used = 0;
+        chunk->size = size;
+        _chunks = chunk;
+    }
+    char* copy = reinterpret_cast<char*>( _chunks + 1 ) + _chunks->used;
+    memcpy( copy, name, length );
+    copy[length] = 0;
+    _chunks->used += length + 1;
+
+    slot->hash = hash;
+    slot->length = static_cast<uint32_t>( length );
+    slot->name = copy;
+    ++_count;
+    return copy;
+}
+
+
+const char* XMLNameTable::Find( const char* name ) const
+{
+    if ( !_count ) {
+        return 0;
+    }
+    const size_t length = strlen( name );
+    return FindSlot( name, length, XMLUtil::HashName( name, length ) )->name;
+}
+
+
+bool XMLNameTable::Contains( const char* p ) const
+{
+    for ( const Chunk* chunk = _chunks; chunk; chunk = chunk->next ) {
+        const char* chars = reinterpret_cast<const char*>( chunk + 1 );
+        if ( p >= chars && p < chars + chunk->used ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Character classes in the C locale, for the scalar scanners
+enum {
+    CHAR_WHITESPACE = 1,
+    CHAR_NAME = 2
+};
+
+struct CharClassTable {
+    unsigned char flags[256];
+
+    CharClassTable() {
+        for ( int c = 0; c < 256; ++c ) {
+            const unsigned char ch = static_cast<unsigned char>( c );
+            flags[c] = 0;
+            if ( ch == ' ' || ( ch >= 0x09 && ch <= 0x0d ) ) {
+                flags[c] |= CHAR_WHITESPACE;
+            }
+            if ( XMLUtil::IsNameChar( ch ) ) {
+                flags[c] |= CHAR_NAME;
+            }
+        }
+    }
+};
+
+static const CharClassTable charClass;
+
+#if defined(TIXML_SCAN_SSE2)
+
+static inline __m128i InRange( __m128i v, char lo, char hi )
+{
+    // Unsigned lo <= v <= hi via a signed compare on the biased difference
+    const __m128i bias = _mm_set1_epi8( static_cast<char>( 0x80 ) );
+    const __m128i d = _mm_xor_si128( _mm_sub_epi8( v, _mm_set1_epi8( lo ) ), bias );
+    return _mm_cmplt_epi8( d, _mm_set1_epi8( static_cast<char>( ( hi - lo + 1 ) ^ 0x80 ) ) );
+}
+
+// Scans from p for the first byte where stop() is set, 16 bytes at a time
+template <class Stop>
+TIXML_SCAN_FUNCTION static inline const char* ScanBlocks( const char* p, Stop stop )
+{
+    const size_t misalign = reinterpret_cast<uintptr_t>( p ) & 15;
+    const char* block = p - misalign;
+    unsigned mask = stop( _mm_load_si128( reinterpret_cast<const __m128i*>( block ) ) ) & ( 0xffffu << misalign );
+    while ( !mask ) {
+        block += 16;
+        mask = stop( _mm_load_si128( reinterpret_cast<const __m128i*>( block ) ) );
+    }
+    return block + __builtin_ctz( mask );
+}
+
+struct StopText {
+    __m128i endChar;
+    unsigned operator()( __m128i v ) const {
+        const __m128i hit = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, endChar ),
+                                                        _mm_cmpeq_epi8( v, _mm_set1_epi8( '\n' ) ) ),
+                                          _mm_cmpeq_epi8( v, _mm_setzero_si128() ) );
+        return static_cast<unsigned>( _mm_movemask_epi8( hit ) );
+    }
+};
+
+struct StopName {
+    unsigned operator()( __m128i v ) const {
+        // Bytes >= 128 are name characters, as in XMLUtil::IsNameStartChar()
+        __m128i name = _mm_cmplt_epi8( v, _mm_setzero_si128() );
+        name = _mm_or_si128( name, InRange( _mm_or_si128( v, _mm_set1_epi8( 0x20 ) ), 'a', 'z' ) );
+        name = _mm_or_si128( name, InRange( v, '0', ':' ) );
+        name = _mm_or_si128( name, InRange( v, '-', '.' ) );
+        name = _mm_or_si128( name, _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) ) );
+        return static_cast<unsigned>( ~_mm_movemask_epi8( name ) ) & 0xffffu;
+    }
+};
+
+struct StopEntity {
+    unsigned operator()( __m128i v ) const {
+        __m128i hit = _mm_cmpeq_epi8( v, _mm_setzero_si128() );
+        hit = _mm_or_si128( hit, _mm_cmpeq_epi8( v, _mm_set1_epi8( '\"' ) ) );
+        hit = _mm_or_si128( hit, InRange( v, '&', '\'' ) );
+        hit = _mm_or_si128( hit, _mm_cmpeq_epi8( v, _mm_set1_epi8( '<' ) ) );
+        hit = _mm_or_si128( hit, _mm_cmpeq_epi8( v, _mm_set1_epi8( '>' ) ) );
+        return static_cast<unsigned>( _mm_movemask_epi8( hit ) );
+    }
+};
+
+// First byte that is not whitespace; counts the newlines skipped
+TIXML_SCAN_FUNCTION static const char* ScanWhiteSpace( const char* p, int* curLineNumPtr )
+{
+    const __m128i newline = _mm_set1_epi8( '\n' );
+    const size_t misalign = reinterpret_cast<uintptr_t>( p ) & 15;
+    const char* block = p - misalign;
+    unsigned valid = ( 0xffffu << misalign ) & 0xffffu;
+    for ( ;; ) {
+        const __m128i v = _mm_load_si128( reinterpret_cast<const __m128i*>( block ) );
+        const __m128i ws = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ), InRange( v, 0x09, 0x0d ) );
+        const unsigned stop = ~static_cast<unsigned>( _mm_movemask_epi8( ws ) ) & valid;
+        unsigned newlines = static_cast<unsigned>( _mm_movemask_epi8( _mm_cmpeq_epi8( v, newline ) ) ) & valid;
+        if ( stop ) {
+            newlines &= ( stop & ( 0u - stop ) ) - 1;
+        }
+        if ( curLineNumPtr ) {
+            *curLineNumPtr += __builtin_popcount( newlines );
+        }
+        if ( stop ) {
+            return block + __builtin_ctz( stop );
+        }
+        valid = 0xffffu;
+        block += 16;
+    }
+}
+
+static inline const char* ScanText( const char* p, char endChar )
+{
+    StopText stop = { _mm_set1_epi8( endChar ) };
+    return ScanBlocks( p, stop );
+}
+
+static inline const char* ScanName( const char* p )
+{
+    return ScanBlocks( p, StopName() );
+}
+
+static inline const char* ScanEntity( const char* p )
+{
+    return ScanBlocks( p, StopEntity() );
+}
+
+#else
+
+static const char* ScanWhiteSpace( const char* p, int* curLineNumPtr )
+{
+    while ( charClass.flags[static_cast<unsigned char>( *p )] & CHAR_WHITESPACE ) {
+        if ( curLineNumPtr && *p == '\n' ) {
+            ++( *curLineNumPtr );
+        }
+        ++p;
+    }
+    return p;
+}
+
+static inline const char* ScanName( const char* p )
+{
+    while ( charClass.flags[static_cast<unsigned char>( *p )] & CHAR_NAME ) {
+        ++p;
+    }
+    return p;
+}
+
+#if defined(TIXML_SCAN_SWAR)
+
+typedef uintptr_t ScanWord;
+// Word loads of char data; may_alias keeps them within strict aliasing
+typedef uintptr_t __attribute__(( may_alias )) ScanAliasWord;
+static const ScanWord SCAN_ONES = ~static_cast<ScanWord>( 0 ) / 255;
+static const ScanWord SCAN_HIGHS = SCAN_ONES * 0x80;
+
+// High bit set in the lowest byte of w that equals c. Higher bytes may be
+// flagged spuriously, so only the lowest flag of an OR of these is exact.
+static inline ScanWord HasByte( ScanWord w, unsigned char c )
+{
+    const ScanWord x = w ^ ( SCAN_ONES * c );
+    return ( x - SCAN_ONES ) & ~x & SCAN_HIGHS;
+}
+
+// Index of the lowest flagged byte (little endian: the first in memory).
+// uintptr_t is wider than long on LLP64 targets such as mingw-w64.
+static inline int LowestFlaggedByte( ScanWord mask )
+{
+    return ( sizeof( ScanWord ) > sizeof( unsigned long ) ? __builtin_ctzll( mask ) : __builtin_ctzl( mask ) ) / 8;
+}
+
+// Byte at a time up to word alignment, then a word at a time until hit()
+// flags a word, whose lowest flagged byte is the result
+template <class Hit>
+TIXML_SCAN_FUNCTION static inline const char* ScanWords( const char* p, Hit hit )
+{
+    while ( reinterpret_cast<uintptr_t>( p ) & ( sizeof( ScanWord ) - 1 ) ) {
+        if ( hit( static_cast<unsigned char>( *p ) ) ) {
+            return p;
+        }
+        ++p;
+    }
+    const ScanAliasWord* w = reinterpret_cast<const ScanAliasWord*>( p );
+    ScanWord mask;
+    while ( !( mask = hit.Word( *w ) ) ) {
+        ++w;
+    }
+    return reinterpret_cast<const char*>( w ) + LowestFlaggedByte( mask );
+}
+
+struct HitText {
+    unsigned char endChar;
+    bool operator()( unsigned char c ) const {
+        return c == endChar || c == '\n' || c == 0;
+    }
+    ScanWord Word( ScanWord w ) const {
+        return HasByte( w, endChar ) | HasByte( w, '\n' ) | HasByte( w, 0 );
+    }
+};
+
+struct HitEntity {
+    bool operator()( unsigned char c ) const {
+        return c == '"' || c == '&' || c == '\'' || c == '<' || c == '>' || c == 0;
+    }
+    ScanWord Word( ScanWord w ) const {
+        return HasByte( w, '"' ) | HasByte( w, '&' ) | HasByte( w, '\'' )
+             | HasByte( w, '<' ) | HasByte( w, '>' ) | HasByte( w, 0 );
+    }
+};
+
+static inline const char* ScanText( const char* p, char endChar )
+{
+    HitText hit = { static_cast<unsigned char>( endChar ) };
+    return ScanWords( p, hit );
+}
+
+static inline const char* ScanEntity( const char* p )
+{
+    return ScanWords( p, HitEntity() );
+}
+
+#else
+
+static inline const char* ScanText( const char* p, char endChar )
+{
+    while ( *p && *p != endChar && *p != '\n' ) {
+        ++p;
+    }
+    return p;
+}
+
+static inline const char* ScanEntity( const char* p )
+{
+    while ( *p && *p != '"' && *p != '&' && *p != '\'' && *p != '<' && *p != '>' ) {
+        ++p;
+    }
+    return p;
+}
+
+#endif
+#endif
+
+
+const char* XMLUtil::SkipWhiteSpaceRun( const char* p, int* curLineNumPtr )
+{
+    return ScanWhiteSpace( p, curLineNumPtr );
+}
+
+
 struct Entity {
     const char* pattern;
     int length;
@@ -191,6 +590,19 @@ void StrPair::Reset()
 }
 
 
+void StrPair::InternName( XMLNameTable* table )
+{
+    // Names need no normalization, so a parsed slice is the final string.
+    // It is not NUL-terminated yet, and must not be while parsing goes on.
+    TIXMLASSERT( ( _flags & ~( NEEDS_FLUSH | NEEDS_DELETE ) ) == 0 );
+    const size_t length = ( _flags & NEEDS_FLUSH ) ? static_cast<size_t>( _end - _start ) : strlen( _start );
+    const char* name = table->Intern( _start, length );
+    Reset();
+    _start = const_cast<char*>( name );
+    _end = _start + length;
+}
+
+
 void StrPair::SetStr( const char* str, int flags )
 {
     TIXMLASSERT( str );
@@ -214,8 +626,12 @@ char* StrPair::ParseText( char* p, const char* endTag, int strFlags, int* curLin
     const char  endChar = *endTag;
     size_t length = strlen( endTag );
 
-    // Inner loop of text parsing.
-    while ( *p ) {
+    // Inner loop of text parsing: jump to the next end character or newline
+    for ( ;; ) {
+        p = const_cast<char*>( ScanText( p, endChar ) );
+        if ( !*p ) {
+            return 0;
+        }
         if ( *p == endChar && strncmp( p, endTag, length ) == 0 ) {
             Set( start, p, strFlags );
             return p + length;
@@ -225,7 +641,6 @@ char* StrPair::ParseText( char* p, const char* endTag, int strFlags, int* curLin
         ++p;
         TIXMLASSERT( p );
     }
-    return 0;
 }
 
 
@@ -239,10 +654,7 @@ char* StrPair::ParseName( char* p )
     }
 
     char* const start = p;
-    ++p;
-    while ( *p && XMLUtil::IsNameChar( static_cast<unsigned char>(*p) ) ) {
-        ++p;
-    }
+    p = const_cast<char*>( ScanName( p + 1 ) );
 
     Set( start, p, 0 );
     return p;
@@ -854,7 +1266,10 @@ const char* XMLNode::Value() const
 
 void XMLNode::SetValue( const char* str, bool staticMem )
 {
-    if ( staticMem ) {
+    if ( _document && _document->_nameTable && ToElement() ) {
+        _value.SetInternedStr( _document->_nameTable->Intern( str ) );
+    }
+    else if ( staticMem ) {
         _value.SetInternedStr( str );
     }
     else {
@@ -1023,8 +1438,12 @@ XMLNode* XMLNode::InsertAfterChild( XMLNode* afterThis, XMLNode* addThis )
 
 const XMLElement* XMLNode::FirstChildElement( const char* name ) const
 {
+    if ( !ResolveName( name ) ) {
+        return 0;
+    }
+    const bool interned = name && _document->_nameTable;
     for( const XMLNode* node = _firstChild; node; node = node->_next ) {
-        const XMLElement* element = node->ToElementWithName( name );
+        const XMLElement* element = node->ToElementWithName( name, interned );
         if ( element ) {
             return element;
         }
@@ -1035,8 +1454,12 @@ const XMLElement* XMLNode::FirstChildElement( const char* name ) const
 
 const XMLElement* XMLNode::LastChildElement( const char* name ) const
 {
+    if ( !ResolveName( name ) ) {
+        return 0;
+    }
+    const bool interned = name && _document->_nameTable;
     for( const XMLNode* node = _lastChild; node; node = node->_prev ) {
-        const XMLElement* element = node->ToElementWithName( name );
+        const XMLElement* element = node->ToElementWithName( name, interned );
         if ( element ) {
             return element;
         }
@@ -1047,8 +1470,12 @@ const XMLElement* XMLNode::LastChildElement( const char* name ) const
 
 const XMLElement* XMLNode::NextSiblingElement( const char* name ) const
 {
+    if ( !ResolveName( name ) ) {
+        return 0;
+    }
+    const bool interned = name && _document->_nameTable;
     for( const XMLNode* node = _next; node; node = node->_next ) {
-        const XMLElement* element = node->ToElementWithName( name );
+        const XMLElement* element = node->ToElementWithName( name, interned );
         if ( element ) {
             return element;
         }
@@ -1059,8 +1486,12 @@ const XMLElement* XMLNode::NextSiblingElement( const char* name ) const
 
 const XMLElement* XMLNode::PreviousSiblingElement( const char* name ) const
 {
+    if ( !ResolveName( name ) ) {
+        return 0;
+    }
+    const bool interned = name && _document->_nameTable;
     for( const XMLNode* node = _prev; node; node = node->_prev ) {
-        const XMLElement* element = node->ToElementWithName( name );
+        const XMLElement* element = node->ToElementWithName( name, interned );
         if ( element ) {
             return element;
         }
@@ -1214,7 +1645,7 @@ void XMLNode::InsertChildPreamble( XMLNode* insertThis ) const
 	}
 }
 
-const XMLElement* XMLNode::ToElementWithName( const char* name ) const
+const XMLElement* XMLNode::ToElementWithName( const char* name, bool interned ) const
 {
     const XMLElement* element = this->ToElement();
     if ( element == 0 ) {
@@ -1223,12 +1654,25 @@ const XMLElement* XMLNode::ToElementWithName( const char* name ) const
     if ( name == 0 ) {
         return element;
     }
-    if ( XMLUtil::StringEqual( element->Name(), name ) ) {
+    if ( interned ? element->_value.InternedStr() == name : XMLUtil::StringEqual( element->Name(), name ) ) {
        return element;
     }
     return 0;
 }
 
+
+// With a name table, swaps name for its interned copy so elements can be
+// matched by pointer. Returns false if no element can have that name.
+bool XMLNode::ResolveName( const char*& name ) const
+{
+    const XMLNameTable* names = _document ? _document->_nameTable : 0;
+    if ( !name || !names || names->Contains( name ) ) {
+        return true;
+    }
+    name = names->Find( name );
+    return name != 0;
+}
+
 // --------- XMLText ---------- //
 char* XMLText::ParseDeep( char* p, StrPair*, int* curLineNumPtr )
 {
@@ -1598,7 +2042,10 @@ void XMLAttribute::SetAttribute( float v )
 // --------- XMLElement ---------- //
 XMLElement::XMLElement( XMLDocument* doc ) : XMLNode( doc ),
     _closingType( OPEN ),
-    _rootAttribute( 0 )
+    _rootAttribute( 0 ),
+    _attributeCount( 0 ),
+    _attributeIndex( 0 ),
+    _attributeIndexCapacity( 0 )
 {
 }
 
@@ -1615,6 +2062,22 @@ XMLElement::~XMLElement()
 
 const XMLAttribute* XMLElement::FindAttribute( const char* name ) const
 {
+    if ( _document->_nameTable ) {
+        // Interned names: compare pointers
+        if ( !ResolveName( name ) ) {
+            return 0;
+        }
+        for( XMLAttribute* a = _rootAttribute; a; a = a->_next ) {
+            if ( a->_name.InternedStr() == name ) {
+                return a;
+            }
+        }
+        return 0;
+    }
+    const size_t indexMin = _document->_attributeIndexMin;
+    if ( indexMin && _attributeCount >= indexMin ) {
+        return FindIndexedAttribute( name );
+    }
     for( XMLAttribute* a = _rootAttribute; a; a = a->_next ) {
         if ( XMLUtil::StringEqual( a->Name(), name ) ) {
             return a;
@@ -1913,30 +2376,108 @@ XMLAttribute* XMLElement::FindOrCreateAttribute( const char* name )
 {
     XMLAttribute* last = 0;
     XMLAttribute* attrib = 0;
-    for( attrib = _rootAttribute;
-            attrib;
-            last = attrib, attrib = attrib->_next ) {
-        if ( XMLUtil::StringEqual( attrib->Name(), name ) ) {
-            break;
+    if ( _document->_nameTable || _attributeIndexCapacity ) {
+        attrib = const_cast<XMLAttribute*>( FindAttribute( name ) );
+        if ( attrib ) {
+            return attrib;
+        }
+        for( last = _rootAttribute; last && last->_next; last = last->_next ) {
+        }
+    }
+    else {
+        for( attrib = _rootAttribute;
+                attrib;
+                last = attrib, attrib = attrib->_next ) {
+            if ( XMLUtil::StringEqual( attrib->Name(), name ) ) {
+                break;
+            }
         }
     }
     if ( !attrib ) {
         attrib = CreateAttribute();
         TIXMLASSERT( attrib );
-        if ( last ) {
-            TIXMLASSERT( last->_next == 0 );
-            last->_next = attrib;
+        if ( _document->_nameTable ) {
+            attrib->_name.SetInternedStr( _document->_nameTable->Intern( name ) );
         }
         else {
-            TIXMLASSERT( _rootAttribute == 0 );
-            _rootAttribute = attrib;
+            attrib->SetName( name );
         }
-        attrib->SetName( name );
+        AppendAttribute( last, attrib );
     }
     return attrib;
 }
 
 
+void XMLElement::AppendAttribute( XMLAttribute* last, XMLAttribute* attrib )
+{
+    if ( last ) {
+        TIXMLASSERT( last->_next == 0 );
+        last->_next = attrib;
+    }
+    else {
+        TIXMLASSERT( _rootAttribute == 0 );
+        _rootAttribute = attrib;
+    }
+    ++_attributeCount;
+    if ( _attributeIndexCapacity ) {
+        IndexAttribute( attrib );
+    }
+}
+
+
+const XMLAttribute* XMLElement::FindIndexedAttribute( const char* name ) const
+{
+    if ( !_attributeIndexCapacity ) {
+        BuildAttributeIndex( _attributeCount * 2 );
+    }
+    const uint32_t hash = XMLUtil::HashName( name );
+    const size_t mask = _attributeIndexCapacity - 1;
+    const XMLAttributeSlot* slots = &_document->_attributeSlots[_attributeIndex];
+    for( size_t i = hash & mask; slots[i].attribute; i = (i + 1) & mask ) {
+        if ( slots[i].hash == hash && XMLUtil::StringEqual( slots[i].attribute->Name(), name ) ) {
+            return slots[i].attribute;
+        }
+    }
+    return 0;
+}
+
+
+void XMLElement::BuildAttributeIndex( size_t capacity ) const
+{
+    // Power of two, at most half full
+    size_t size = 16;
+    while ( size < capacity ) {
+        size *= 2;
+    }
+    DynArray<XMLAttributeSlot, 16>& slots = _document->_attributeSlots;
+    _attributeIndex = slots.Size();
+    _attributeIndexCapacity = size;
+    memset( slots.PushArr( size ), 0, sizeof( XMLAttributeSlot ) * size );
+    for( const XMLAttribute* a = _rootAttribute; a; a = a->_next ) {
+        IndexAttribute( a );
+    }
+}
+
+
+void XMLElement::IndexAttribute( const XMLAttribute* attrib ) const
+{
+    if ( _attributeCount * 2 > _attributeIndexCapacity ) {
+        // Grown past half full: the old slots stay unused until Clear()
+        BuildAttributeIndex( _attributeIndexCapacity * 2 );
+        return;
+    }
+    const uint32_t hash = XMLUtil::HashName( attrib->Name() );
+    const size_t mask = _attributeIndexCapacity - 1;
+    XMLAttributeSlot* slots = &_document->_attributeSlots[_attributeIndex];
+    size_t i = hash & mask;
+    while ( slots[i].attribute ) {
+        i = (i + 1) & mask;
+    }
+    slots[i].hash = hash;
+    slots[i].attribute = attrib;
+}
+
+
 void XMLElement::DeleteAttribute( const char* name )
 {
     XMLAttribute* prev = 0;
@@ -1949,6 +2490,9 @@ void XMLElement::DeleteAttribute( const char* name )
                 _rootAttribute = a->_next;
             }
             DeleteAttribute( a );
+            --_attributeCount;
+            // Rebuilt on the next lookup
+            _attributeIndexCapacity = 0;
             break;
         }
         prev = a;
@@ -1977,24 +2521,18 @@ char* XMLElement::ParseAttributes( char* p, int* curLineNumPtr )
             const int attrLineNum = attrib->_parseLineNum;
 
             p = attrib->ParseDeep( p, _document->ProcessEntities(), curLineNumPtr );
+            if ( p && _document->_nameTable ) {
+                attrib->_name.InternName( _document->_nameTable );
+            }
             if ( !p || Attribute( attrib->Name() ) ) {
                 DeleteAttribute( attrib );
                 _document->SetError( XML_ERROR_PARSING_ATTRIBUTE, attrLineNum, "XMLElement name=%s", Name() );
                 return 0;
             }
-            // There is a minor bug here: if the attribute in the source xml
-            // document is duplicated, it will not be detected and the
-            // attribute will be doubly added. However, tracking the 'prevAttribute'
-            // avoids re-scanning the attribute list. Preferring performance for
-            // now, may reconsider in the future.
-            if ( prevAttribute ) {
-                TIXMLASSERT( prevAttribute->_next == 0 );
-                prevAttribute->_next = attrib;
-            }
-            else {
-                TIXMLASSERT( _rootAttribute == 0 );
-                _rootAttribute = attrib;
-            }
+            // Tracking the 'prevAttribute' avoids re-scanning the attribute
+            // list; on wide elements the duplicate check above goes through
+            // the attribute index instead of a linear walk.
+            AppendAttribute( prevAttribute, attrib );
             prevAttribute = attrib;
         }
         // end of the tag
@@ -2089,6 +2627,9 @@ char* XMLElement::ParseDeep( char* p, StrPair* parentEndTag, int* curLineNumPtr
     if ( _value.Empty() ) {
         return 0;
     }
+    if ( _document->_nameTable ) {
+        _value.InternName( _document->_nameTable );
+    }
 
     p = ParseAttributes( p, curLineNumPtr );
     if ( !p || !*p || _closingType != OPEN ) {
@@ -2106,7 +2647,7 @@ XMLNode* XMLElement::ShallowClone( XMLDocument* doc ) const
     if ( !doc ) {
         doc = _document;
     }
-    XMLElement* element = doc->NewElement( Value() );					// fixme: this will always allocate memory. Intern?
+    XMLElement* element = doc->NewElement( Value() );					// allocates unless doc has a name table
     for( const XMLAttribute* a=FirstAttribute(); a; a=a->Next() ) {
         element->SetAttribute( a->Name(), a->Value() );					// fixme: this will always allocate memory. Intern?
     }
@@ -2189,9 +2730,16 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
     _errorStr(),
     _errorLineNum( 0 ),
     _charBuffer( 0 ),
+    _charBufferSize( 0 ),
+    _nCharBufferAllocs( 0 ),
+    _inSituBuffer( 0 ),
+    _inSituOwner( 0 ),
     _parseCurLineNum( 0 ),
 	_parsingDepth(0),
     _unlinked(),
+    _attributeSlots(),
+    _attributeIndexMin( 0 ),
+    _nameTable( 0 ),
     _elementPool(),
     _attributePool(),
     _textPool(),
@@ -2205,6 +2753,57 @@ XMLDocument::XMLDocument( bool processEntities, Whitespace whitespaceMode ) :
 XMLDocument::~XMLDocument()
 {
     Clear();
+    delete [] _charBuffer;
+}
+
+
+void XMLDocument::SetAllocator( XMLAllocator* allocator )
+{
+    Clear();
+    _unlinked.SetAllocator( allocator );
+    _attributeSlots.SetAllocator( allocator );
+    _elementPool.SetAllocator( allocator );
+    _attributePool.SetAllocator( allocator );
+    _textPool.SetAllocator( allocator );
+    _commentPool.SetAllocator( allocator );
+}
+
+
+void XMLDocument::SetNameTable( XMLNameTable* table )
+{
+    Clear();
+    _nameTable = table;
+}
+
+
+void XMLDocument::SetBlockSize( size_t bytes )
+{
+    Clear();
+    _elementPool.SetBlockSize( bytes );
+    _attributePool.SetBlockSize( bytes );
+    _textPool.SetBlockSize( bytes );
+    _commentPool.SetBlockSize( bytes );
+}
+
+
+size_t XMLDocument::Allocations() const
+{
+    return _elementPool.BlockAllocs() + _attributePool.BlockAllocs()
+         + _textPool.BlockAllocs() + _commentPool.BlockAllocs() + _nCharBufferAllocs;
+}
+
+
+char* XMLDocument::ReserveCharBuffer( size_t size )
+{
+    // The buffer only grows, so a reused document stops allocating
+    if ( size + 1 > _charBufferSize ) {
+        delete [] _charBuffer;
+        _charBuffer = new char[size+1];
+        _charBufferSize = size + 1;
+        ++_nCharBufferAllocs;
+    }
+    _charBuffer[size] = 0;
+    return _charBuffer;
 }
 
 
@@ -2233,8 +2832,13 @@ void XMLDocument::Clear()
 #endif
     ClearError();
 
-    delete [] _charBuffer;
-    _charBuffer = 0;
+    if ( _inSituOwner ) {
+        _inSituOwner->Deallocate( _inSituBuffer );
+    }
+    _inSituBuffer = 0;
+    _inSituOwner = 0;
+
+    _attributeSlots.Clear();
 	_parsingDepth = 0;
 
 #if 0
@@ -2399,8 +3003,7 @@ XMLError XMLDocument::LoadFile( FILE* fp )
     }
 
     const size_t size = static_cast<size_t>(filelength);
-    TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[size+1];
+    ReserveCharBuffer( size );
     const size_t read = fread( _charBuffer, 1, size, fp );
     if ( read != size ) {
         SetError( XML_ERROR_FILE_READ_ERROR, 0, 0 );
@@ -2409,7 +3012,7 @@ XMLError XMLDocument::LoadFile( FILE* fp )
 
     _charBuffer[size] = 0;
 
-    Parse();
+    Parse( _charBuffer );
     return _errorID;
 }
 
@@ -2455,26 +3058,60 @@ XMLError XMLDocument::Parse( const char* xml, size_t nBytes )
     if ( nBytes == static_cast<size_t>(-1) ) {
         nBytes = strlen( xml );
     }
-    TIXMLASSERT( _charBuffer == 0 );
-    _charBuffer = new char[ nBytes+1 ];
+    ReserveCharBuffer( nBytes );
     memcpy( _charBuffer, xml, nBytes );
-    _charBuffer[nBytes] = 0;
 
-    Parse();
+    Parse( _charBuffer );
     if ( Error() ) {
-        // clean up now essentially dangling memory.
-        // and the parse fail can put objects in the
-        // pools that are dead and inaccessible.
-        DeleteChildren();
-        _elementPool.Clear();
-        _attributePool.Clear();
-        _textPool.Clear();
-        _commentPool.Clear();
+        ResetAfterError();
     }
     return _errorID;
 }
 
 
+XMLError XMLDocument::ParseInSitu( char* xml, size_t nBytes, XMLAllocator* owner )
+{
+    Clear();
+
+    // Taken even if it turns out to be empty, so it is never leaked
+    if ( xml && owner ) {
+        _inSituBuffer = xml;
+        _inSituOwner = owner;
+    }
+    if ( nBytes == 0 || !xml || !*xml ) {
+        SetError( XML_ERROR_EMPTY_DOCUMENT, 0, 0 );
+        return _errorID;
+    }
+    if ( nBytes == static_cast<size_t>(-1) ) {
+        nBytes = strlen( xml );
+    }
+    xml[nBytes] = 0;
+
+    Parse( xml );
+    if ( Error() ) {
+        ResetAfterError();
+    }
+    return _errorID;
+}
+
+
+void XMLDocument::ResetAfterError()
+{
+    // clean up now essentially dangling memory.
+    // and the parse fail can put objects in the
+    // pools that are dead and inaccessible.
+    // The blocks themselves are kept for the next parse.
+    DeleteChildren();
+    while( _unlinked.Size()) {
+        DeleteNode(_unlinked[0]);
+    }
+    _elementPool.Reset();
+    _attributePool.Reset();
+    _textPool.Reset();
+    _commentPool.Reset();
+}
+
+
 void XMLDocument::Print( XMLPrinter* streamer ) const
 {
     if ( streamer ) {
@@ -2547,13 +3184,12 @@ const char* XMLDocument::ErrorName() const
     return ErrorIDToName(_errorID);
 }
 
-void XMLDocument::Parse()
+void XMLDocument::Parse( char* p )
 {
     TIXMLASSERT( NoChildren() ); // Clear() must have been called previously
-    TIXMLASSERT( _charBuffer );
+    TIXMLASSERT( p );
     _parseCurLineNum = 1;
     _parseLineNum = 1;
-    char* p = _charBuffer;
     p = XMLUtil::SkipWhiteSpace( p, &_parseCurLineNum );
     p = const_cast<char*>( XMLUtil::ReadBOM( p, &_writeBOM ) );
     if ( !*p ) {
@@ -2670,7 +3306,12 @@ void XMLPrinter::PrintString( const char* p, bool restricted )
 
     if ( _processEntities ) {
         const bool* flag = restricted ? _restrictedEntityFlag : _entityFlag;
-        while ( *q ) {
+        for ( ;; ) {
+            // Skip to the next byte that may need an entity
+            q = ScanEntity( q );
+            if ( !*q ) {
+                break;
+            }
             TIXMLASSERT( p <= q );
             // Remember, char is sometimes signed. (How many times has that bitten me?)
             if ( *q > 0 && *q < ENTITY_RANGE ) {
@@ -121,6 +121,7 @@ class XMLText;
 class XMLDeclaration;
 class XMLUnknown;
 class XMLPrinter;
+class XMLNameTable;
 
 /*
 	A class that wraps strings. Normally stores the start and end
@@ -167,6 +168,14 @@ public:
     void SetInternedStr( const char* str ) {
         Reset();
         _start = const_cast<char*>(str);
+        _end = _start + strlen( str );
+    }
+
+    // Replaces a name with its canonical copy from the table
+    void InternName( XMLNameTable* table );
+    // The canonical copy after InternName(), without going through GetStr()
+    const char* InternedStr() const {
+        return _start;
     }
 
     void SetStr( const char* str, int flags=0 );
@@ -194,10 +203,126 @@ private:
 };
 
 
+/**
+	Source of the memory behind DynArray storage and MemPoolT blocks.
+	Implement it to place a document in a specific memory region (PSRAM,
+	internal SRAM, an arena...). Heap() is the default and uses malloc/free.
+*/
+class TINYXML2_LIB XMLAllocator
+{
+public:
+    virtual ~XMLAllocator() {}
+
+    /// Returns size bytes aligned for any node type. Must not return null.
+    virtual void* Allocate( size_t size ) = 0;
+    virtual void Deallocate( void* mem ) = 0;
+
+    static XMLAllocator* Heap();
+};
+
+
+/**
+	Bump allocator over caller-provided memory. Deallocate() only returns
+	memory to the fallback allocator, so it suits a long-lived document
+	that is cleared and parsed again: the pools fill the arena once and
+	then recycle the same blocks. Allocations that do not fit go to the
+	fallback (the heap by default).
+*/
+class TINYXML2_LIB XMLArena : public XMLAllocator
+{
+public:
+    XMLArena() : _mem(0), _size(0), _used(0), _fallback(Heap()) {}
+    XMLArena( void* mem, size_t size, XMLAllocator* fallback = Heap() ) :
+        _mem(static_cast<char*>(mem)), _size(mem ? size : 0), _used(0), _fallback(fallback) {}
+
+    virtual void* Allocate( size_t size ) override {
+        const size_t align = sizeof(void*) < 8 ? 8 : sizeof(void*);
+        const size_t start = (_used + align - 1) & ~(align - 1);
+        if ( !_mem || start > _size || size > _size - start ) {
+            return _fallback->Allocate( size );
+        }
+        _used = start + size;
+        return _mem + start;
+    }
+    virtual void Deallocate( void* mem ) override {
+        if ( !Owns( mem ) ) {
+            _fallback->Deallocate( mem );
+        }
+    }
+    bool Owns( const void* p ) const {
+        const char* c = static_cast<const char*>(p);
+        return _mem && c >= _mem && c < _mem + _size;
+    }
+    size_t Size() const { return _size; }
+    size_t Used() const { return _used; }
+
+private:
+    char*  _mem;
+    size_t _size;
+    size_t _used;
+    XMLAllocator* _fallback;
+};
+
+
+/**
+	Intern table for element and attribute names. A document with a name
+	table stores every name as a pointer to its canonical copy, so equal
+	names have equal pointers and lookups by name compare pointers. The
+	table is not owned by the document, survives XMLDocument::Clear() and
+	can be shared by several documents, which makes names comparable across
+	them. Names are only released when the table is destroyed.
+*/
+class TINYXML2_LIB XMLNameTable
+{
+public:
+    explicit XMLNameTable( XMLAllocator* allocator = XMLAllocator::Heap() );
+    ~XMLNameTable();
+
+    /// Canonical copy of the name, added if it is new.
+    const char* Intern( const char* name, size_t length );
+    const char* Intern( const char* name ) {
+        return Intern( name, strlen( name ) );
+    }
+    /// Canonical copy of the name, or null if it was never interned.
+    const char* Find( const char* name ) const;
+    /// True if p is a canonical copy returned by this table.
+    bool Contains( const char* p ) const;
+
+    size_t Size() const {
+        return _count;
+    }
+
+private:
+    XMLNameTable( const XMLNameTable& );	// not supported
+    void operator=( const XMLNameTable& );	// not supported
+
+    struct Slot {
+        uint32_t hash;
+        uint32_t length;
+        const char* name;
+    };
+    // Names are stored back to back in chunks; the characters follow the header
+    struct Chunk {
+        Chunk* next;
+        size_t used;
+        size_t size;
+    };
+
+    const Slot* FindSlot( const char* name, size_t length, uint32_t hash ) const;
+    void Grow();
+
+    XMLAllocator* _allocator;
+    Slot*  _slots;
+    size_t _capacity;
+    size_t _count;
+    Chunk* _chunks;
+};
+
+
 /*
 	A dynamic array of Plain Old Data. Doesn't support constructors, etc.
 	Has a small initial memory pool, so that low or no usage will not
-	cause a call to new/delete
+	cause a call to the allocator
 */
 template <class T, size_t INITIAL_SIZE>
 class DynArray
@@ -206,14 +331,30 @@ public:
     DynArray() :
         _mem( _pool ),
         _allocated( INITIAL_SIZE ),
-        _size( 0 )
+        _size( 0 ),
+        _allocator( XMLAllocator::Heap() )
     {
     }
 
     ~DynArray() {
         if ( _mem != _pool ) {
-            delete [] _mem;
+            _allocator->Deallocate( _mem );
+        }
+    }
+
+    // Moves storage that outgrew the initial pool to the new allocator
+    void SetAllocator( XMLAllocator* allocator ) {
+        TIXMLASSERT( allocator );
+        if ( allocator == _allocator ) {
+            return;
+        }
+        if ( _mem != _pool ) {
+            T* newMem = static_cast<T*>( allocator->Allocate( sizeof(T) * _allocated ) );
+            memcpy( newMem, _mem, sizeof(T) * _size );
+            _allocator->Deallocate( _mem );
+            _mem = newMem;
         }
+        _allocator = allocator;
     }
 
     void Clear() {
@@ -300,11 +441,11 @@ private:
         if ( cap > _allocated ) {
             TIXMLASSERT( cap <= SIZE_MAX / 2 / sizeof(T));
             const size_t newAllocated = cap * 2;
-            T* newMem = new T[newAllocated];
+            T* newMem = static_cast<T*>( _allocator->Allocate( sizeof(T) * newAllocated ) );
             TIXMLASSERT( newAllocated >= _size );
             memcpy( newMem, _mem, sizeof(T) * _size );	// warning: not using constructors, only works for PODs
             if ( _mem != _pool ) {
-                delete [] _mem;
+                _allocator->Deallocate( _mem );
             }
             _mem = newMem;
             _allocated = newAllocated;
@@ -315,6 +456,7 @@ private:
     T   _pool[INITIAL_SIZE];
     size_t _allocated;		// objects allocated
     size_t _size;			// number objects in use
+    XMLAllocator* _allocator;
 };
 
 
@@ -342,7 +484,8 @@ template< size_t ITEM_SIZE >
 class MemPoolT : public MemPool
 {
 public:
-    MemPoolT() : _blockPtrs(), _root(0), _currentAllocs(0), _nAllocs(0), _maxAllocs(0), _nUntracked(0)	{}
+    MemPoolT() : _blockPtrs(), _root(0), _allocator(XMLAllocator::Heap()), _itemsPerBlock(ITEMS_PER_BLOCK),
+        _currentAllocs(0), _nAllocs(0), _maxAllocs(0), _nUntracked(0), _nBlockAllocs(0)	{}
     ~MemPoolT() {
         MemPoolT< ITEM_SIZE >::Clear();
     }
@@ -350,8 +493,8 @@ public:
     void Clear() {
         // Delete the blocks.
         while( !_blockPtrs.Empty()) {
-            Block* lastBlock = _blockPtrs.Pop();
-            delete lastBlock;
+            Item* lastBlock = _blockPtrs.Pop();
+            _allocator->Deallocate( lastBlock );
         }
         _root = 0;
         _currentAllocs = 0;
@@ -360,6 +503,44 @@ public:
         _nUntracked = 0;
     }
 
+    // Puts every item back on the free list but keeps the blocks. Only valid
+    // when no item is in use any more, e.g. after a failed parse.
+    void Reset() {
+        _root = 0;
+        for( size_t b = 0; b < _blockPtrs.Size(); ++b ) {
+            Item* blockItems = _blockPtrs[b];
+            for( size_t i = 0; i < _itemsPerBlock - 1; ++i ) {
+                blockItems[i].next = &(blockItems[i + 1]);
+            }
+            blockItems[_itemsPerBlock - 1].next = _root;
+            _root = blockItems;
+        }
+        _currentAllocs = 0;
+        _nUntracked = 0;
+    }
+
+    // Both only take effect on an empty pool: existing blocks are released
+    // first, so no item may be in use.
+    void SetAllocator( XMLAllocator* allocator ) {
+        TIXMLASSERT( allocator && _currentAllocs == 0 );
+        Clear();
+        _allocator = allocator;
+        _blockPtrs.SetAllocator( allocator );
+    }
+    void SetBlockSize( size_t bytes ) {
+        TIXMLASSERT( _currentAllocs == 0 );
+        Clear();
+        _itemsPerBlock = bytes / ITEM_SIZE > 1 ? bytes / ITEM_SIZE : 1;
+    }
+    size_t BlockSize() const {
+        return _itemsPerBlock * ITEM_SIZE;
+    }
+
+    // Number of blocks ever allocated; stays flat while blocks are recycled
+    size_t BlockAllocs() const {
+        return _nBlockAllocs;
+    }
+
     virtual size_t ItemSize() const override {
         return ITEM_SIZE;
     }
@@ -370,14 +551,14 @@ public:
     virtual void* Alloc() override{
         if ( !_root ) {
             // Need a new block.
-            Block* block = new Block;
-            _blockPtrs.Push( block );
+            Item* blockItems = static_cast<Item*>( _allocator->Allocate( sizeof( Item ) * _itemsPerBlock ) );
+            _blockPtrs.Push( blockItems );
+            ++_nBlockAllocs;
 
-            Item* blockItems = block->items;
-            for( size_t i = 0; i < ITEMS_PER_BLOCK - 1; ++i ) {
+            for( size_t i = 0; i < _itemsPerBlock - 1; ++i ) {
                 blockItems[i].next = &(blockItems[i + 1]);
             }
-            blockItems[ITEMS_PER_BLOCK - 1].next = 0;
+            blockItems[_itemsPerBlock - 1].next = 0;
             _root = blockItems;
         }
         Item* const result = _root;
@@ -428,6 +609,7 @@ public:
 	//		16k:	5200
 	//		32k:	4300
 	//		64k:	4000	21000
+    // Default block size; see SetBlockSize().
     // Declared public because some compilers do not accept to use ITEMS_PER_BLOCK
     // in private part if ITEMS_PER_BLOCK is private
     enum { ITEMS_PER_BLOCK = (4 * 1024) / ITEM_SIZE };
@@ -440,16 +622,16 @@ private:
         Item*   next;
         char    itemData[static_cast<size_t>(ITEM_SIZE)];
     };
-    struct Block {
-        Item items[ITEMS_PER_BLOCK];
-    };
-    DynArray< Block*, 10 > _blockPtrs;
+    DynArray< Item*, 10 > _blockPtrs;
     Item* _root;
+    XMLAllocator* _allocator;
+    size_t _itemsPerBlock;
 
     size_t _currentAllocs;
     size_t _nAllocs;
     size_t _maxAllocs;
     size_t _nUntracked;
+    size_t _nBlockAllocs;
 };
 
 
@@ -549,6 +731,10 @@ public:
     static const char* SkipWhiteSpace( const char* p, int* curLineNumPtr )	{
         TIXMLASSERT( p );
 
+        // Runs longer than one byte (indentation) are scanned in bulk
+        if ( IsWhiteSpace(*p) && IsWhiteSpace(p[1]) ) {
+            return SkipWhiteSpaceRun( p, curLineNumPtr );
+        }
         while( IsWhiteSpace(*p) ) {
             if (curLineNumPtr && *p == '\n') {
                 ++(*curLineNumPtr);
@@ -561,6 +747,7 @@ public:
     static char* SkipWhiteSpace( char* const p, int* curLineNumPtr ) {
         return const_cast<char*>( SkipWhiteSpace( const_cast<const char*>(p), curLineNumPtr ) );
     }
+    static const char* SkipWhiteSpaceRun( const char* p, int* curLineNumPtr );
 
     // Anything in the high order range of UTF-8 is assumed to not be whitespace. This isn't
     // correct, but simple, and usually works.
@@ -601,6 +788,22 @@ public:
         return strncmp( p, q, static_cast<size_t>(nChar) ) == 0;
     }
 
+    // FNV-1a, used by the attribute index and the name table
+    inline static uint32_t HashName( const char* p ) {
+        uint32_t h = 2166136261u;
+        while ( *p ) {
+            h = ( h ^ static_cast<unsigned char>(*p++) ) * 16777619u;
+        }
+        return h;
+    }
+    inline static uint32_t HashName( const char* p, size_t length ) {
+        uint32_t h = 2166136261u;
+        for ( size_t i = 0; i < length; ++i ) {
+            h = ( h ^ static_cast<unsigned char>(p[i]) ) * 16777619u;
+        }
+        return h;
+    }
+
     inline static bool IsUTF8Continuation( const char p ) {
         return ( p & 0x80 ) != 0;
     }
@@ -970,7 +1173,8 @@ private:
     void Unlink( XMLNode* child );
     static void DeleteNode( XMLNode* node );
     void InsertChildPreamble( XMLNode* insertThis ) const;
-    const XMLElement* ToElementWithName( const char* name ) const;
+    const XMLElement* ToElementWithName( const char* name, bool interned ) const;
+    bool ResolveName( const char*& name ) const;
 
     XMLNode( const XMLNode& );	// not supported
     XMLNode& operator=( const XMLNode& );	// not supported
@@ -1693,6 +1897,15 @@ private:
     char* ParseAttributes( char* p, int* curLineNumPtr );
     static void DeleteAttribute( XMLAttribute* attribute );
     XMLAttribute* CreateAttribute();
+    void AppendAttribute( XMLAttribute* last, XMLAttribute* attrib );
+
+    // Attribute index: an open-addressed hash table over the attribute list,
+    // built on the first lookup once the element has enough attributes (see
+    // XMLDocument::SetAttributeIndexThreshold). Its slots live in the
+    // document, so building one allocates nothing in steady state.
+    const XMLAttribute* FindIndexedAttribute( const char* name ) const;
+    void BuildAttributeIndex( size_t capacity ) const;
+    void IndexAttribute( const XMLAttribute* attrib ) const;
 
     enum { BUF_SIZE = 200 };
     ElementClosingType _closingType;
@@ -1700,6 +1913,16 @@ private:
     // because the list needs to be scanned for dupes before adding
     // a new attribute.
     XMLAttribute* _rootAttribute;
+    size_t _attributeCount;
+    mutable size_t _attributeIndex;          // first slot in the document
+    mutable size_t _attributeIndexCapacity;  // 0 while there is no index
+};
+
+
+// One slot of an element's attribute index
+struct XMLAttributeSlot {
+    uint32_t hash;
+    const XMLAttribute* attribute;
 };
 
 
@@ -1751,6 +1974,19 @@ public:
     */
     XMLError Parse( const char* xml, size_t nBytes=static_cast<size_t>(-1) );
 
+    /**
+    	Parse a buffer in place instead of copying it first. Parsing
+    	writes into the buffer, and the document's names and values
+    	point into it, so xml[nBytes] must be writable (it is set to
+    	NUL). If nBytes is not given, 'xml' must be null terminated.
+
+    	Without an owner the buffer is borrowed and must outlive the
+    	document's nodes. With an owner the document takes the buffer
+    	and releases it through owner->Deallocate() when it is cleared,
+    	parses again or is destroyed - also if parsing fails.
+    */
+    XMLError ParseInSitu( char* xml, size_t nBytes=static_cast<size_t>(-1), XMLAllocator* owner=0 );
+
     /**
     	Load an XML file from disk.
     	Returns XML_SUCCESS (0) on success, or
@@ -1904,9 +2140,56 @@ public:
         return _errorLineNum;
     }
 
-    /// Clear the document, resetting it to the initial state.
+    /**
+    	Clear the document, resetting it to the initial state.
+    	The node pools and the text buffer are kept for the next Parse(),
+    	so a document that is reused does not allocate again once it has
+    	seen its largest input. Destroy the document to release them.
+    	A buffer handed over with ParseInSitu() is released here.
+    */
     void Clear();
 
+    /**
+    	Allocate node pool blocks and internal arrays from the given
+    	allocator instead of the heap, e.g. PSRAM or an XMLArena. The
+    	allocator is not owned and must outlive the document; it can be
+    	shared by several documents. Clears the document.
+    */
+    void SetAllocator( XMLAllocator* allocator );
+
+    /**
+    	Size in bytes of each node pool block (default 4 KB). Small blocks
+    	waste less memory on small documents, large ones allocate less often
+    	on big documents. Clears the document.
+    */
+    void SetBlockSize( size_t bytes );
+
+    /// Number of allocations made by the pools and text buffer.
+    size_t Allocations() const;
+
+    /**
+    	Intern element and attribute names in the given table (null to turn
+    	interning off, the default). Name lookups then compare pointers, and
+    	names are comparable by pointer across documents sharing the table.
+    	The table is not owned and must outlive the document. Clears the
+    	document.
+    */
+    void SetNameTable( XMLNameTable* table );
+    XMLNameTable* NameTable() const {
+        return _nameTable;
+    }
+
+    /**
+    	Elements with at least this many attributes get a hashed attribute
+    	index on the first lookup. Lookups on narrower elements, or all
+    	lookups if 0 (the default), walk the attribute list. The duplicate
+    	checks of parsing build the index too, which slows parsing down, so
+    	it pays off only for documents with many lookups per element.
+    */
+    void SetAttributeIndexThreshold( size_t attributes ) {
+        _attributeIndexMin = attributes;
+    }
+
 	/**
 		Copies this document to a target document.
 		The target will be completely cleared before the copy.
@@ -1940,6 +2223,10 @@ private:
     mutable StrPair	_errorStr;
     int             _errorLineNum;
     char*			_charBuffer;
+    size_t			_charBufferSize;
+    size_t			_nCharBufferAllocs;
+    char*			_inSituBuffer;		// taken by ParseInSitu(), or null
+    XMLAllocator*	_inSituOwner;
     int				_parseCurLineNum;
 	int				_parsingDepth;
 	// Memory tracking does add some overhead.
@@ -1950,6 +2237,11 @@ private:
 	// and the performance is the same.
 	DynArray<XMLNode*, 10> _unlinked;
 
+	// Slots of all element attribute indexes; emptied by Clear()
+	DynArray<XMLAttributeSlot, 16> _attributeSlots;
+	size_t _attributeIndexMin;
+	XMLNameTable* _nameTable;
+
     MemPoolT< sizeof(XMLElement) >	 _elementPool;
     MemPoolT< sizeof(XMLAttribute) > _attributePool;
     MemPoolT< sizeof(XMLText) >		 _textPool;
@@ -1957,7 +2249,9 @@ private:
 
 	static const char* _errorNames[XML_ERROR_COUNT];
 
-    void Parse();
+    void Parse( char* p );
+    void ResetAfterError();
+    char* ReserveCharBuffer( size_t size );
 
     void SetError( XMLError error, int lineNum, const char* format, ... );
 
@@ -3,26 +3,97 @@
 // Initialize static member
 LVML* LVML::mInstance = nullptr;
 
-LVML::LVML() {
+LVML::LVML() : mXmlNames(&mPsramAllocator), mPrefetcher(&LVML::downloadToBuffer) {
   mServerUrl = "";
   mCurrentUrl = "";
   mCurrentUi = nullptr;
   screen_counter = 0;
+  mCurrentComponent = "";
+  mScreenUrl = "";
+  mPatchMode = true;
+  mPreferCompiled = false;
+  mPrefetchImages = true;
+  mProgressiveBuild = true;
+  mLazyBuild = false;
+  mShareStyles = false;
+  mLazyCounter = 0;
+  mComponentCount = 0;
+  mPendingUrl = "";
+  mNavigationStart = 0;
+  mLastNavigationMs = 0;
+  mNavigations = 0;
+  mCoalescedNavigations = 0;
+  mLoadStart = 0;
+  mLvglHeap = LVMLHeapStats();
+  mStageMark = 0;
+  mStagesDone = 0;
+  mBuildTimer = nullptr;
+  mBuildStart = 0;
+  mBuildSlices = 0;
+  mBuildWidgets = 0;
+
+  // The arena gets its PSRAM block in begin()
+  for (tinyxml2::XMLDocument *doc : {&mDoc, &mPatchDoc}) {
+    doc->SetAllocator(&mXmlArena);
+    doc->SetBlockSize(LVML_XML_BLOCK_SIZE);
+    doc->SetNameTable(&mXmlNames);
+  }
+  mImageTag = nullptr;
+  mViewTag = nullptr;
+  mDataHost = "";
+  mDataPort = 0;
+  mDataLastAttempt = 0;
+  mDataLine = "";
+  mDataLineCut = false;
+  mEventPath = "";
+  mEventServer = "";
+  mEventLastAttempt = 0;
+  mEventHeadersDone = false;
+  mEventStatusDone = false;
+  mEventRefused = false;
+  mEventLine = "";
+  mEventData = "";
 }
 
 LVML::~LVML() {
+  lv_async_call_cancel(pendingLoadAsync, this);
+  cancelBuild();
+  releaseLazySubtrees();
   if (mCurrentUi) {
     lv_obj_del(mCurrentUi);
   }
   
   // Clean up downloaded image descriptors
   cleanupImageDescriptors();
+
+  mDataClient.stop();
+  mEventClient.stop();
+  for (auto& pair : mSubjects) {
+    lv_subject_deinit(&pair.second->subject);
+    delete pair.second;
+  }
+  mSubjects.clear();
 }
 
 void LVML::begin() {
   // Set this instance as the current one for callbacks
   setInstance(this);
   
+  // Node pools of the parse documents live in PSRAM and are reused by every
+  // load. A global LVML is constructed before PSRAM is set up, so this
+  // cannot happen in the constructor.
+  if (!mXmlArenaMemory.memory()) {
+    void *memory = mXmlArenaMemory.allocate(LVML_XML_ARENA_SIZE);
+    if (memory) {
+      mXmlArena = tinyxml2::XMLArena(memory, LVML_XML_ARENA_SIZE, &mPsramAllocator);
+    } else {
+      LVML_LOGW("No PSRAM for the %d byte XML arena, node pools use the heap", LVML_XML_ARENA_SIZE);
+    }
+  }
+  mImageTag = mXmlNames.Intern("lv_image");
+  mViewTag = mXmlNames.Intern("view");
+
+  lv_log_register_print_cb(lvmlLogLvgl);
   lv_xml_register_event_cb(NULL, "load_screen", loadScreenCallback);
 }
 
@@ -30,122 +101,494 @@ void LVML::setInstance(LVML* instance) {
   mInstance = instance;
 }
 
+void LVML::setPatchMode(bool enabled) {
+  mPatchMode = enabled;
+}
+
+void LVML::setPreferCompiled(bool enabled) {
+  mPreferCompiled = enabled;
+}
+
+void LVML::setPrefetchImages(bool enabled) {
+  mPrefetchImages = enabled;
+}
+
+void LVML::setProgressiveBuild(bool enabled) {
+  mProgressiveBuild = enabled;
+}
+
+void LVML::setLazyBuild(bool enabled) {
+  mLazyBuild = enabled;
+}
+
+void LVML::setShareStyles(bool enabled) {
+  mShareStyles = enabled;
+}
+
 // Generic screen loading callback function
-void LVML::loadScreenXml(String xmlContent) {
+void LVML::loadScreenXml(const String &xmlContent) {
+  loadScreenXml(LVMLBuffer::copyOf(xmlContent.c_str(), xmlContent.length()));
+}
+
+static size_t countWidgets(tinyxml2::XMLElement* element);
+
+void LVML::loadScreenXml(LVMLBuffer &&xmlContent) {
   if (xmlContent.length() > 0) {
+    // A screen still being built reads from mDoc, which is parsed again
+    // below. Only a screen that may be patched has to be completed first.
+    if (mPatchMode && mScreenUrl == mCurrentUrl) {
+      finishBuild();
+    } else {
+      cancelBuild();
+    }
+
     // Find src attributes and download images, replace src with descriptor name
-    xmlContent = preprocessXmlForImages(xmlContent);
+    xmlContent = preprocessXmlForImages(std::move(xmlContent));
+    mPrefetcher.clear();
+    if (xmlContent.length() == 0) {
+      discardScreenArena();
+      LVML_LOGW("Keeping the current screen");
+      return;
+    }
+    sampleLoadMemory(LVML_PHASE_PREPROCESS);
+    markLoadStage(LVML_STAGE_PREPROCESS);
+
+    // The kept copy must not borrow from the screen's memory
+    xmlContent.makeOwned();
+
+    // Same URL reloaded: try to patch the widgets already on screen, with
+    // its deferred subtrees built so that the whole tree can be compared
+    if (mPatchMode && mCurrentUi && mScreenUrl == mCurrentUrl && mCurrentXml.length() > 0) {
+      expandLazySubtrees();
+      if (patchScreenXml(xmlContent)) {
+        // The slices are in the arena released below
+        releaseLazySubtrees();
+        mCurrentXml = std::move(xmlContent);
+        sampleLoadMemory(LVML_PHASE_CREATE);
+        markLoadStage(LVML_STAGE_CREATE);
+        commitScreenArena();
+        LVML_LOGI("Screen patched in place");
+        onLoadScreen();
+        return;
+      }
+      LVML_LOGW("Patch not possible, rebuilding screen");
+    }
 
     // Generate a unique name for the component
     String componentName = "screen_" + String(screen_counter++);
+    String previousComponent = mCurrentComponent;
     
     // Register the new component
-    lv_xml_component_register_from_data(componentName.c_str(), xmlContent.c_str());
+    {
+      LVML_TRACE_SCOPE("register");
+      lv_xml_component_register_from_data(componentName.c_str(), xmlContent.c_str());
+    }
+    mComponentCount++;
     
     // Remove the current UI
-    if (mCurrentUi) {
-      lv_obj_del(mCurrentUi);
+    {
+      LVML_TRACE_SCOPE("delete_screen");
+      releaseLazySubtrees();
+      if (mCurrentUi) {
+        lv_obj_del(mCurrentUi);
+      }
     }
+    mLazySubtrees = std::move(mLoadingLazy);
+    mLoadingLazy.clear();
     
-    // Create the new UI
-    mCurrentUi = (lv_obj_t *)lv_xml_create(lv_scr_act(), componentName.c_str(), NULL);
+    // Create the new UI, large screens a slice at a time from mDoc (which
+    // holds the tree the component was printed from)
+    tinyxml2::XMLElement* view = mDoc.RootElement() ? mDoc.RootElement()->FirstChildElement("view") : nullptr;
+    {
+      LVML_TRACE_SCOPE("create");
+      if (mProgressiveBuild && view && countWidgets(view) >= LVML_PROGRESSIVE_MIN_WIDGETS) {
+        // Slices create widgets in the component's scope
+        mCurrentComponent = componentName;
+        mCurrentUi = startBuild(view);
+        if (!mCurrentUi) mCurrentComponent = "";
+      } else {
+        mCurrentUi = (lv_obj_t *)lv_xml_create(lv_scr_act(), componentName.c_str(), NULL);
+      }
+    }
     if (mCurrentUi) {
-      Serial.printf("Screen loaded successfully!\n");
+      mCurrentXml = std::move(xmlContent);
+      mCurrentComponent = componentName;
+      mScreenUrl = mCurrentUrl;
+      if (!mBuildTimer) {
+        attachLazySubtrees();
+      }
+      LVML_LOGI("Screen loaded successfully!");
     } else {
-      Serial.printf("Failed to create screen\n");
+      mCurrentXml.clear();
+      mCurrentComponent = "";
+      mScreenUrl = "";
+      unregisterComponent(componentName);
+      LVML_LOGW("Failed to create screen");
     }
+
+    // The previous screen's widgets are gone; its styles and constants can go too
+    unregisterComponent(previousComponent);
+    sampleLoadMemory(LVML_PHASE_CREATE);
+    markLoadStage(LVML_STAGE_CREATE);
+    commitScreenArena();
     
     onLoadScreen();
 
   } else {
-    Serial.printf("Failed to load from server\n");
+    discardScreenArena();
+    LVML_LOGW("Failed to load from server");
   }
 }
 void LVML::loadScreenUrl(String url) {
+  LVML_TRACE_SCOPE("load_screen");
   // Store the current URL for relative path resolution
   mCurrentUrl = url;
   
   // get server url from url
   mServerUrl = url.substring(0, url.indexOf("/", 8));
-  Serial.printf("Server URL: %s\n", mServerUrl.c_str());
+  LVML_LOGD("Server URL: %s", mServerUrl.c_str());
+
+  mLvglHeap = lvmlLvglHeapStats();
+  mLoadMemory.begin(lvmlMemoryInUse(mLvglHeap), lvmlMemoryHighWater(mLvglHeap));
+  mLoadStart = mStageMark = micros();
+  mStagesDone = 0;
+
+  // Precompiled screens skip XML parsing altogether
+  String compiledUrl = url;
+  if (mPreferCompiled && url.endsWith(".xml")) {
+    compiledUrl = url.substring(0, url.length() - 4) + LVML_COMPILED_EXTENSION;
+  }
+  if (compiledUrl.endsWith(LVML_COMPILED_EXTENSION)) {
+    size_t size = 0;
+    uint8_t *data = downloadToBuffer(compiledUrl, &size, true);
+    if (data) {
+      markLoadStage(LVML_STAGE_FETCH);
+      loadScreenCompiled(data, size);
+      free(data);
+      finishLoadMemory();
+      finishLoadStages();
+      return;
+    }
+    if (compiledUrl == url) {
+      finishLoadMemory();
+      finishLoadStages();
+      return;
+    }
+    LVML_LOGW("No compiled screen, falling back to XML");
+  }
+
+  LVMLBuffer::resetStats();
+  LVMLBuffer xmlContent = url.endsWith(LVML_BUNDLE_EXTENSION) ? loadBundleFromURL(url) : loadXMLFromURL(url);
+  if (xmlContent.length() > 0) {
+    markLoadStage(LVML_STAGE_FETCH);
+  }
+  loadScreenXml(std::move(xmlContent));
 
-  String xmlContent = loadXMLFromURL(url);
-  loadScreenXml(xmlContent);
+  // Buffer traffic of this load, from the first body byte to registration
+  LVML_LOGI("Screen load: %u allocations, %u bytes copied",
+            (unsigned)LVMLBuffer::allocations(), (unsigned)LVMLBuffer::bytesCopied());
+  finishLoadMemory();
+  finishLoadStages();
 }
 
-String LVML::loadXMLFromURL(String url) {
+void LVML::sampleLoadMemory(LVMLLoadPhase phase) {
+  // lvmlLvglHeapStats() walks every block of LVGL's pool, so it runs once
+  // per phase and the other users take this snapshot
+  if (mLoadMemory.active()) {
+    mLvglHeap = lvmlLvglHeapStats();
+    mLoadMemory.sample(phase, lvmlMemoryInUse(mLvglHeap), lvmlMemoryHighWater(mLvglHeap));
+  }
+}
+
+void LVML::finishLoadMemory() {
+  if (!mLoadMemory.active()) return;
+  sampleLoadMemory(LVML_PHASE_RELEASE);
+  LVML_LOGI("LVGL heap: %d of %d bytes used, peak %d, largest free %d, fragmentation %d%%",
+            (int)mLvglHeap.used, (int)mLvglHeap.total, (int)mLvglHeap.peak, (int)mLvglHeap.largestFree,
+            (int)mLvglHeap.fragmentation);
+  LVMLLoadMemory load;
+  mLoadMemory.end(load);
+
+  // Failed loads left the previous screen in place and cost nothing lasting
+  if (!(load.sampled & (1 << LVML_PHASE_CREATE))) return;
+  LVMLLoadTracker::record(mScreenMemory[mCurrentUrl], load);
+  char line[192];
+  LVMLLoadTracker::format(load, line, sizeof(line));
+  LVML_LOGI("Memory %s: %s", mCurrentUrl.c_str(), line);
+}
+
+void LVML::markLoadStage(LVMLLoadStage stage) {
+  if (!mStageMark) return;
+  unsigned long now = micros();
+  LVMLMetrics::instance().load[stage].observe(now - mStageMark);
+  mStageMark = now;
+  mStagesDone |= 1 << stage;
+}
+
+void LVML::finishLoadStages() {
+  if (!mStageMark) return;
+  LVMLMetrics &metrics = LVMLMetrics::instance();
+  // A load counts when it put a screen up; failed ones keep the old screen
+  if ((mStagesDone & (1 << LVML_STAGE_CREATE)) && mCurrentUi) {
+    metrics.load[LVML_STAGE_TOTAL].observe(micros() - mLoadStart);
+    metrics.loadsOk++;
+  } else {
+    metrics.loadsFailed++;
+  }
+  mStageMark = 0;
+}
+
+LVMLBuffer LVML::loadXMLFromURL(const String &url) {
+  LVML_TRACE_SCOPE("fetch_xml");
   HTTPClient http;
   http.begin(url);
+
+  // XML compresses very well; inflate gzip/deflate bodies while they arrive
+  const char *headerKeys[] = {"Content-Encoding"};
+  http.collectHeaders(headerKeys, 1);
+  http.addHeader("Accept-Encoding", "gzip, deflate");
+
+  unsigned long start = millis();
   int httpCode = http.GET();
   if (httpCode != HTTP_CODE_OK) {
-    Serial.printf("HTTP GET failed, error: %s\n", http.errorToString(httpCode).c_str());
-    return "";
+    LVML_LOGW("HTTP GET failed, error: %s", http.errorToString(httpCode).c_str());
+    http.end();
+    return LVMLBuffer();
+  }
+
+  // Start tags are scanned as the body arrives, so images can be fetched
+  // in parallel with the rest of the XML
+  ImagePrefetchListener listener(this);
+  LVMLXmlScanner scanner(&listener);
+  mPrefetcher.clear();
+
+  LVMLBuffer xmlContent;
+  String encoding = http.header("Content-Encoding");
+  if (encoding == "gzip" || encoding == "deflate") {
+    LVMLInflateStream inflater(encoding == "gzip");
+    if (mPrefetchImages) {
+      LVMLScanStream scan(inflater, inflater.output(), scanner);
+      http.writeToStream(&scan);
+    } else {
+      http.writeToStream(&inflater);
+    }
+    if (inflater.failed() || !inflater.done()) {
+      LVML_LOGW("Failed to inflate %s body", encoding.c_str());
+    } else {
+      xmlContent = std::move(inflater.output());
+    }
+    // Wall-clock cost of the transfer versus CPU spent inflating
+    LVML_LOGI("XML fetched: %d bytes from %d (%s) in %lu ms, inflate %lu us",
+              (int)inflater.bytesOut(), (int)inflater.bytesIn(), encoding.c_str(),
+              millis() - start, inflater.inflateMicros());
+  } else {
+    // Stream the body straight into one buffer sized from Content-Length
+    int size = http.getSize();
+    if (size > 0) {
+      xmlContent.reserve(size);
+    }
+    LVMLBufferStream sink(xmlContent);
+    if (mPrefetchImages) {
+      LVMLScanStream scan(sink, xmlContent, scanner);
+      http.writeToStream(&scan);
+    } else {
+      http.writeToStream(&sink);
+    }
+    LVML_LOGI("XML fetched: %d bytes in %lu ms", (int)xmlContent.length(), millis() - start);
   }
-  String xmlContent = http.getString();
   http.end();
+  if (mPrefetchImages) {
+    LVML_LOGD("XML scanned while fetching: %d element(s), %d image(s) queued",
+              (int)scanner.elements(), (int)mPrefetcher.requests());
+  }
   return xmlContent;
 }
 
+void LVML::ImagePrefetchListener::startElement(const char *name, const char *const *attrs, size_t count) {
+  if (strcmp(name, "lv_image") != 0) return;
+  for (size_t i = 0; i < count; i++) {
+    if (strcmp(attrs[2 * i], "src") == 0) {
+      mOwner->mPrefetcher.request(mOwner->resolveImageUrl(String(attrs[2 * i + 1])));
+      return;
+    }
+  }
+}
+
+LVMLBuffer LVML::loadBundleFromURL(const String &url) {
+  LVML_TRACE_SCOPE("fetch_bundle");
+  // The bundle belongs to the screen and is freed with it
+  size_t size = 0;
+  uint8_t *data = downloadTo(url, &size, true, &mLoadingArena);
+  if (!data) {
+    return LVMLBuffer();
+  }
+
+  LVMLBundleEntry entries[LVML_BUNDLE_MAX_ENTRIES];
+  size_t count = lvmlBundleParse(data, size, entries, LVML_BUNDLE_MAX_ENTRIES);
+  if (count == 0) {
+    LVML_LOGW("Invalid bundle: %s", url.c_str());
+    return LVMLBuffer();
+  }
+
+  LVMLBundleEntry *images = (LVMLBundleEntry *)mLoadingArena.allocate(sizeof(LVMLBundleEntry) * count);
+  if (!images) {
+    return LVMLBuffer();
+  }
+  memcpy(images, entries + 1, sizeof(LVMLBundleEntry) * (count - 1));
+  mBundle.entries = images;
+  mBundle.count = count - 1;
+  LVML_LOGI("Bundle loaded: %s, %d bytes, %d image(s)", url.c_str(), (int)size, (int)count - 1);
+
+  // Entry 0 is the screen XML, NUL-terminated in place
+  return LVMLBuffer::borrow((const char *)entries[0].data, entries[0].size);
+}
+
+const LVMLBundleEntry* LVML::findBundleEntry(const String &url) {
+  if (!mBundle.entries || !url.startsWith(mServerUrl)) return nullptr;
+  const char *path = url.c_str() + mServerUrl.length();
+  for (size_t i = 0; i < mBundle.count; i++) {
+    if (strcmp(mBundle.entries[i].path, path) == 0) return &mBundle.entries[i];
+  }
+  return nullptr;
+}
+
+//--------------------------------
+// Screen arenas
+// Everything a screen owns is allocated from the loading arena and freed in
+// one go once the next screen has replaced it
+//--------------------------------
+void LVML::commitScreenArena() {
+  LVML_TRACE_SCOPE("commit_arena");
+  mScreenArena.swap(mLoadingArena);
+  mScreenImageUrls.swap(mLoadingImageUrls);
+  mLoadingImageUrls.clear();
+  mBundle = ScreenBundle();
+
+  // The loading arena now holds the previous screen, whose widgets are gone
+  resetScreenArena(mLoadingArena);
+
+  // Largest free block against free memory shows how scattered the heap is
+  LVML_LOGI("Screen arena: %d bytes in %d chunk(s), %d reserved; internal heap %d free, largest block %d",
+            (int)mScreenArena.used(), (int)mScreenArena.chunks(), (int)mScreenArena.reserved(),
+            (int)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+            (int)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+}
+
+void LVML::discardScreenArena() {
+  mLoadingImageUrls.clear();
+  mBundle = ScreenBundle();
+  resetScreenArena(mLoadingArena);
+}
+
+void LVML::resetScreenArena(LVMLArena &arena) {
+  // Descriptors not taken over by the new screen must not keep pointing
+  // into freed memory
+  for (auto& pair : mImageDescriptors) {
+    if (pair.second->data && arena.contains(pair.second->data)) {
+      lv_image_cache_drop(pair.second);
+      pair.second->data = nullptr;
+      pair.second->data_size = 0;
+    }
+  }
+  arena.reset();
+}
+
 void LVML::onLoadScreen() {
-  Serial.println("On load screen");
+  LVML_LOGD("On load screen");
 }
 
-String LVML::preprocessXmlForImages(String xmlContent) {
-  Serial.println("Preprocessing XML for images...");
-  
-  tinyxml2::XMLDocument doc;
-  tinyxml2::XMLError parseResult = doc.Parse(xmlContent.c_str());
+LVMLBuffer LVML::preprocessXmlForImages(LVMLBuffer &&xmlContent) {
+  LVML_TRACE_SCOPE("preprocess");
+  LVML_LOGD("Preprocessing XML for images...");
   
+  // The document is reused, so its pools only grow until they fit the
+  // largest screen seen so far. The text is parsed in place: an owned
+  // buffer is handed to the document, which frees it on the next parse,
+  // and a bundle's XML is borrowed, since the bundle outlives this load.
+  tinyxml2::XMLDocument &doc = mDoc;
+  size_t docAllocations = doc.Allocations();
+  size_t length = xmlContent.length();
+  tinyxml2::XMLError parseResult;
+  {
+    LVML_TRACE_SCOPE("parse");
+    if (xmlContent.isBorrowed()) {
+      parseResult = doc.ParseInSitu(xmlContent.data(), length);
+    } else {
+      parseResult = doc.ParseInSitu(xmlContent.release(), length, &mPsramAllocator);
+    }
+  }
+  LVML_LOGI("XML parsed: %d new pool allocation(s), arena %d/%d bytes",
+            (int)(doc.Allocations() - docAllocations), (int)mXmlArena.Used(), (int)mXmlArena.Size());
+
+  // The text was consumed by parsing, so there is nothing to fall back to
   if (parseResult != tinyxml2::XML_SUCCESS) {
-    Serial.printf("XML parsing failed: %s\n", doc.ErrorStr());
-    return xmlContent; // Return original if parsing fails
+    LVML_LOGW("XML parsing failed: %s", doc.ErrorStr());
+    return LVMLBuffer();
   }
   
   tinyxml2::XMLElement* root = doc.RootElement();
   if (!root) {
-    Serial.println("No root element found in XML");
-    return xmlContent;
+    LVML_LOGW("No root element found in XML");
+    return LVMLBuffer();
   }
   
   // Find all lv_image elements recursively
+  mLoadingImageUrls.clear();
   processImageElements(root);
+
+  // Make sure every subject referenced by bind_* attributes exists
+  processBindings(root);
+
+  // Repeated inline styles become shared styles of the component
+  tinyxml2::XMLElement* view = root->FirstChildElement("view");
+  if (mShareStyles && view) {
+    shareStyles(root, view);
+  }
+
+  // Cut out subtrees that are not visible yet; images, bindings and styles
+  // inside them have been handled above. A reload that may be patched keeps
+  // its whole tree, which patching compares with the screen on display.
+  mLoadingLazy.clear();
+  if (view) {
+    bool patchable = mPatchMode && mCurrentUi && mScreenUrl == mCurrentUrl;
+    collectLazySubtrees(view, patchable);
+    if (!mLoadingLazy.empty()) {
+      size_t widgets = 0;
+      for (const LazySubtree &subtree : mLoadingLazy) widgets += subtree.widgets;
+      LVML_LOGI("Deferred %d lazy subtree(s) with %d widget(s)", (int)mLoadingLazy.size(), (int)widgets);
+    }
+  }
   
-  // Convert back to string
-  tinyxml2::XMLPrinter printer;
+  // Print the rewritten document into a buffer of about the same size
+  LVML_TRACE_SCOPE("print");
+  LVMLBuffer rewritten;
+  rewritten.reserve(length + length / 8);
+  LVMLBufferPrinter printer(rewritten);
   doc.Print(&printer);
-  return String(printer.CStr());
+  return rewritten;
 }
 
 void LVML::processImageElements(tinyxml2::XMLElement* element) {
   if (!element) return;
   
   // Check if current element is lv_image
-  if (strcmp(element->Name(), "lv_image") == 0) {
+  if (element->Name() == mImageTag) {
     const char* src = element->Attribute("src");
     if (src) {
       String srcUrl = String(src);
-      Serial.printf("Found image source: %s\n", srcUrl.c_str());
+      LVML_LOGD("Found image source: %s", srcUrl.c_str());
       
       // Resolve the URL
       String fullUrl = resolveImageUrl(srcUrl);
+      const char *storedUrl = mLoadingArena.copyString(fullUrl);
+      if (storedUrl) {
+        mLoadingImageUrls.push_back(storedUrl);
+      }
       
-      // Download the image and get descriptor
-      lv_image_dsc_t *imgDesc = downloadImageToDescriptor(fullUrl);
-      
-      if (imgDesc) {
-        // Store the descriptor with a unique name
-        String descName = generateImageDescriptorName(fullUrl);
-        mImageDescriptors[descName] = imgDesc;
-        
+      String descName = loadImage(fullUrl);
+      if (descName.length() > 0) {
         // Replace the src attribute with the descriptor name
         element->SetAttribute("src", descName.c_str());
-        
-        // Register the image with LVGL's XML system so it can be found
-        lv_xml_register_image(NULL, descName.c_str(), imgDesc);
-        
-        Serial.printf("Successfully downloaded and stored image: %s as %s\n", fullUrl.c_str(), descName.c_str());
-      } else {
-        Serial.printf("Failed to download image: %s\n", fullUrl.c_str());
       }
     }
   }
@@ -157,6 +600,89 @@ void LVML::processImageElements(tinyxml2::XMLElement* element) {
   }
 }
 
+void LVML::processBindings(tinyxml2::XMLElement* element) {
+  if (!element) return;
+
+  for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+    if (strncmp(attr->Name(), "bind_", 5) != 0) continue;
+
+    // Point the attribute at the subject of its kind
+    String subject = ensureSubject(attr->Name(), String(attr->Value()));
+    if (subject != attr->Value()) {
+      const_cast<tinyxml2::XMLAttribute*>(attr)->SetAttribute(subject.c_str());
+    }
+  }
+
+  for (tinyxml2::XMLElement* child = element->FirstChildElement();
+       child; child = child->NextSiblingElement()) {
+    processBindings(child);
+  }
+}
+
+String LVML::ensureSubject(const char *bindAttribute, const String &key) {
+  // Labels show text, everything else (bar, slider, arc, flags) is numeric.
+  // A key bound both ways gets one subject of each type.
+  bool isString = strcmp(bindAttribute, "bind_text") == 0;
+  String name = isString ? key : key + "#value";
+  if (mSubjects.count(name)) return name;
+
+  DataSubject *data = new DataSubject();
+  data->isString = isString;
+  if (data->isString) {
+    lv_subject_init_string(&data->subject, data->buf, data->prevBuf, sizeof(data->buf), "");
+  } else {
+    lv_subject_init_int(&data->subject, 0);
+  }
+  lv_xml_register_subject(NULL, name.c_str(), &data->subject);
+  mSubjects[name] = data;
+  LVML_LOGD("Registered subject: %s (%s)", name.c_str(), data->isString ? "string" : "int");
+  return name;
+}
+
+String LVML::loadImage(const String &fullUrl) {
+  LVML_TRACE_SCOPE("image");
+  // Images shipped in the bundle are used in place, others are downloaded
+  // into the arena of the screen being loaded
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  const LVMLBundleEntry *bundled = findBundleEntry(fullUrl);
+  if (bundled) {
+    data = bundled->data;
+    size = bundled->size;
+    LVMLMetrics::instance().images[LVML_IMAGE_BUNDLE]++;
+  } else {
+    data = downloadImage(fullUrl, &size, mLoadingArena);
+  }
+
+  if (!data) {
+    LVMLMetrics::instance().images[LVML_IMAGE_FAILED]++;
+    LVML_LOGW("Failed to download image: %s", fullUrl.c_str());
+    return "";
+  }
+
+  // LVGL decodes the PNG into its own heap when it is drawn. Without room
+  // for that the image just stays empty, so say so here, going by the heap
+  // as it was when the load started.
+  size_t decodeBytes = lvmlPngDecodeBytes(data, size);
+  if (mLvglHeap.total > 0 && (decodeBytes > mLvglHeap.free || decodeBytes / 2 > mLvglHeap.largestFree)) {
+    LVML_LOGW("Image %s needs %d bytes of LVGL heap to decode, %d free (largest block %d); raise LVML_LV_MEM_SIZE",
+              fullUrl.c_str(), (int)decodeBytes, (int)mLvglHeap.free, (int)mLvglHeap.largestFree);
+  }
+
+  // Store the descriptor with a unique name
+  String descName = generateImageDescriptorName(fullUrl);
+  lv_image_dsc_t *imgDesc = storeImageDescriptor(descName, data, size);
+  if (!imgDesc) {
+    return "";
+  }
+
+  // Register the image with LVGL's XML system so it can be found
+  lv_xml_register_image(NULL, descName.c_str(), imgDesc);
+
+  LVML_LOGD("Successfully downloaded and stored image: %s as %s", fullUrl.c_str(), descName.c_str());
+  return descName;
+}
+
 String LVML::resolveImageUrl(const String &src) {
   // If it's already a full URL, return as is
   if (src.startsWith("http://") || src.startsWith("https://")) {
@@ -181,41 +707,53 @@ String LVML::resolveImageUrl(const String &src) {
   return src;
 }
 
-lv_image_dsc_t* LVML::downloadImageToDescriptor(const String &url) {
+uint8_t* LVML::downloadToBuffer(const String &url, size_t *size, bool psram) {
+  return downloadTo(url, size, psram, nullptr);
+}
+
+// Downloads into the arena if one is given, otherwise into a buffer the
+// caller releases with free()
+uint8_t* LVML::downloadTo(const String &url, size_t *size, bool psram, LVMLArena *arena) {
+  LVML_TRACE_SCOPE("download");
   HTTPClient http;
   http.begin(url);
   
   int httpCode = http.GET();
   if (httpCode != HTTP_CODE_OK) {
-    Serial.printf("HTTP GET failed for image, error: %s\n", http.errorToString(httpCode).c_str());
+    LVML_LOGW("HTTP GET failed for %s, error: %s", url.c_str(), http.errorToString(httpCode).c_str());
     http.end();
     return nullptr;
   }
   
-  // Get the image data
+  // Get the data size
   int contentLength = http.getSize();
   if (contentLength <= 0) {
-    Serial.println("Invalid content length for image");
+    LVML_LOGW("Invalid content length for %s", url.c_str());
     http.end();
     return nullptr;
   }
   
-  // Allocate memory for the image data
-  uint8_t *imageData = (uint8_t*)malloc(contentLength);
-  if (!imageData) {
-    Serial.println("Failed to allocate memory for image");
+  // Allocate memory for the data
+  uint8_t *data;
+  if (arena) {
+    data = (uint8_t*)arena->allocate(contentLength);
+  } else {
+    data = (uint8_t*)(psram ? ps_malloc(contentLength) : malloc(contentLength));
+  }
+  if (!data) {
+    LVML_LOGE("Failed to allocate %d bytes for %s", contentLength, url.c_str());
     http.end();
     return nullptr;
   }
   
-  // Read the image data
+  // Read the data
   WiFiClient *stream = http.getStreamPtr();
   int bytesRead = 0;
   while (http.connected() && bytesRead < contentLength) {
     size_t available = stream->available();
     if (available > 0) {
       int toRead = min(available, (size_t)(contentLength - bytesRead));
-      int read = stream->readBytes(imageData + bytesRead, toRead);
+      int read = stream->readBytes(data + bytesRead, toRead);
       bytesRead += read;
     }
     delay(1); // Small delay to prevent watchdog issues
@@ -224,23 +762,29 @@ lv_image_dsc_t* LVML::downloadImageToDescriptor(const String &url) {
   http.end();
   
   if (bytesRead != contentLength) {
-    Serial.printf("Incomplete image download: %d/%d bytes\n", bytesRead, contentLength);
-    free(imageData);
+    LVML_LOGW("Incomplete download: %d/%d bytes", bytesRead, contentLength);
+    if (!arena) {
+      free(data);
+    }
     return nullptr;
   }
-  
+
+  *size = contentLength;
+  return data;
+}
+
+lv_image_dsc_t* LVML::createImageDescriptor(const uint8_t *data, uint32_t size) {
   // Create LVGL image descriptor
-  lv_image_dsc_t *imgDesc = (lv_image_dsc_t*)malloc(sizeof(lv_image_dsc_t));
+  lv_image_dsc_t *imgDesc = (lv_image_dsc_t*)mSessionArena.allocate(sizeof(lv_image_dsc_t));
   if (!imgDesc) {
-    Serial.println("Failed to allocate memory for image descriptor");
-    free(imageData);
+    LVML_LOGE("Failed to allocate memory for image descriptor");
     return nullptr;
   }
   
   // Initialize the descriptor
   memset(imgDesc, 0, sizeof(lv_image_dsc_t));
-  imgDesc->data = imageData;
-  imgDesc->data_size = contentLength;
+  imgDesc->data = data;
+  imgDesc->data_size = size;
   
   // Set image header properties for PNG
   // LVGL 9.x header structure
@@ -252,18 +796,64 @@ lv_image_dsc_t* LVML::downloadImageToDescriptor(const String &url) {
   imgDesc->header.stride = 0;  // Let LVGL calculate this
   imgDesc->header.reserved_2 = 0;
   
-  Serial.printf("Image downloaded successfully: %d bytes\n", contentLength);
-  Serial.printf("Image descriptor created: %dx%d, format: %d\n", 
-                imgDesc->header.w, imgDesc->header.h, imgDesc->header.cf);
+  LVML_LOGD("Image descriptor created: %dx%d, format: %d", 
+            imgDesc->header.w, imgDesc->header.h, imgDesc->header.cf);
+  return imgDesc;
+}
+
+const uint8_t* LVML::downloadImage(const String &url, size_t *size, LVMLArena &arena) {
+  // The prefetcher may have fetched it while the screen XML was arriving.
+  // Its task cannot allocate from the arena, so the data is copied over.
+  uint8_t *data = nullptr;
+  uint8_t *prefetched = mPrefetcher.take(url, size);
+  if (prefetched) {
+    data = (uint8_t*)arena.allocate(*size);
+    if (data) {
+      memcpy(data, prefetched, *size);
+      LVMLMetrics::instance().images[LVML_IMAGE_PREFETCH]++;
+    }
+    free(prefetched);
+  } else {
+    data = downloadTo(url, size, LVML_ARENA_PSRAM, &arena);
+    if (data) LVMLMetrics::instance().images[LVML_IMAGE_DOWNLOAD]++;
+  }
+  if (data) {
+    LVML_LOGD("Image downloaded successfully: %d bytes", (int)*size);
+  }
+  return data;
+}
+
+lv_image_dsc_t* LVML::storeImageDescriptor(const String &name, const uint8_t *data, uint32_t size) {
+  auto it = mImageDescriptors.find(name);
+  if (it != mImageDescriptors.end()) {
+    // Widgets may still reference the registered descriptor, so move the
+    // new pixels into it instead of replacing it
+    setImageData(it->second, data, size);
+    LVMLMetrics::instance().descriptorsReused++;
+    return it->second;
+  }
+
+  lv_image_dsc_t *imgDesc = createImageDescriptor(data, size);
+  if (imgDesc) {
+    mImageDescriptors[name] = imgDesc;
+    LVMLMetrics::instance().descriptorsCreated++;
+  }
   return imgDesc;
 }
 
+void LVML::setImageData(lv_image_dsc_t *imgDesc, const uint8_t *data, uint32_t size) {
+  // The previous pixels belong to a screen arena and go with it
+  lv_image_cache_drop(imgDesc);
+  imgDesc->data = data;
+  imgDesc->data_size = size;
+}
+
 
 
 void LVML::downloadImagesFromXml(String xmlContent) {
   // This method will be called to download all images found in the XML
   // It's a placeholder for the image downloading functionality
-  Serial.println("Downloading images from XML...");
+  LVML_LOGD("Downloading images from XML...");
 }
 
 String LVML::generateImageDescriptorName(const String &url) {
@@ -277,17 +867,1166 @@ String LVML::generateImageDescriptorName(const String &url) {
 }
 
 void LVML::cleanupImageDescriptors() {
-  // Free all downloaded image descriptors and their data
+  // Descriptors and their data are freed with the arenas
   for (auto& pair : mImageDescriptors) {
-    if (pair.second) {
-      if (pair.second->data) {
-        free((void*)pair.second->data);
+    lv_image_cache_drop(pair.second);
+  }
+  mImageDescriptors.clear();
+  mScreenImageUrls.clear();
+  mLoadingImageUrls.clear();
+  mBundle = ScreenBundle();
+  LVML_LOGD("Cleaned up image descriptors");
+}
+
+//--------------------------------
+// Live data channel
+// One "key=value" per line; only the widgets bound to a key are invalidated
+//--------------------------------
+void LVML::beginDataChannel(const String &host, uint16_t port) {
+  mDataHost = host;
+  mDataPort = port;
+  mDataLastAttempt = 0;
+  mDataLine = "";
+  mDataLineCut = false;
+  mDataConnect.cancel();
+  mDataClient.stop();
+}
+
+void LVML::loop() {
+  serviceDataChannel();
+  serviceHotReload();
+}
+
+void LVML::serviceDataChannel() {
+  if (mDataPort == 0) return;
+
+  if (!mDataClient.connected()) {
+    // Attempts start at most every 2 seconds and never block the loop
+    if (!mDataConnect.pending()) {
+      if (mDataLastAttempt != 0 && millis() - mDataLastAttempt < 2000) return;
+      mDataLastAttempt = millis();
+      if (!mDataConnect.start(mDataHost, mDataPort)) return;
+    }
+    if (mDataConnect.poll(mDataClient) <= 0) return;
+    mDataClient.setNoDelay(true);
+    mDataLine = "";
+    mDataLineCut = false;
+    LVML_LOGI("Data channel connected: %s:%d", mDataHost.c_str(), mDataPort);
+  }
+
+  while (mDataClient.available() > 0) {
+    int c = mDataClient.read();
+    if (c < 0) break;
+    if (c == '\n') {
+      if (mDataLineCut) {
+        LVML_LOGW("Data line longer than %d characters cut: %s", LVML_DATA_LINE_MAX - 1, mDataLine.c_str());
       }
-      free(pair.second);
+      handleDataLine(mDataLine);
+      mDataLine = "";
+      mDataLineCut = false;
+    } else if (c == '\r') {
+      continue;
+    } else if (mDataLine.length() < LVML_DATA_LINE_MAX - 1) {
+      mDataLine += (char)c;
+    } else {
+      mDataLineCut = true;
     }
   }
-  mImageDescriptors.clear();
-  Serial.println("Cleaned up image descriptors");
+}
+
+void LVML::handleDataLine(const String &line) {
+  int eq = line.indexOf('=');
+  if (eq <= 0) return;
+  setValue(line.substring(0, eq), line.substring(eq + 1));
+}
+
+void LVML::setValue(const String &key, const String &value) {
+  // A key may have a text and a numeric subject; both get the value
+  bool text = mSubjects.count(key) > 0;
+  bool number = mSubjects.count(key + "#value") > 0;
+  if (text) setSubject(key, value);
+  if (number) setSubject(key + "#value", value);
+  if (text || number) return;
+
+  // No subject: fall back to a widget with that name on the current screen
+  lv_obj_t *obj = findWidget(key.c_str());
+  if (!obj) {
+    LVML_LOGW("No binding for key: %s", key.c_str());
+    return;
+  }
+  if (lv_obj_check_type(obj, &lv_label_class)) {
+    lv_label_set_text(obj, value.c_str());
+  } else if (lv_obj_check_type(obj, &lv_bar_class)) {
+    lv_bar_set_value(obj, value.toInt(), LV_ANIM_OFF);
+  } else if (lv_obj_check_type(obj, &lv_slider_class)) {
+    lv_slider_set_value(obj, value.toInt(), LV_ANIM_OFF);
+  } else if (lv_obj_check_type(obj, &lv_arc_class)) {
+    lv_arc_set_value(obj, value.toInt());
+  } else {
+    LVML_LOGW("Widget %s cannot show a value", key.c_str());
+  }
+}
+
+void LVML::setSubject(const String &name, const String &value) {
+  DataSubject *data = mSubjects[name];
+  if (!data->isString) {
+    lv_subject_set_int(&data->subject, value.toInt());
+    return;
+  }
+  if (value.length() >= sizeof(data->buf)) {
+    LVML_LOGW("Value of %s cut to %d characters", name.c_str(), (int)sizeof(data->buf) - 1);
+  }
+  lv_subject_copy_string(&data->subject, value.c_str());
+}
+
+//--------------------------------
+// Hot reload
+// The server announces changed paths as server-sent events ("data: /main.xml")
+// on a single long-lived connection; nothing is polled
+//--------------------------------
+void LVML::beginHotReload(const String &eventPath) {
+  mEventPath = eventPath;
+  mEventServer = "";
+  mEventLastAttempt = 0;
+  mEventRefused = false;
+  mEventConnect.cancel();
+  mEventClient.stop();
+}
+
+void LVML::serviceHotReload() {
+  if (mEventPath.length() == 0 || mServerUrl.length() == 0) return;
+
+  // Follow navigation to a different server
+  if (mEventServer != mServerUrl) {
+    mEventConnect.cancel();
+    mEventClient.stop();
+    mEventServer = mServerUrl;
+    mEventLastAttempt = 0;
+    mEventRefused = false;
+  }
+  if (mEventRefused) return;
+
+  // mServerUrl is "http://host[:port]"
+  String hostPort = mEventServer.substring(mEventServer.indexOf("//") + 2);
+  if (!mEventClient.connected()) {
+    // Attempts start at most every 5 seconds and never block the loop
+    if (!mEventConnect.pending()) {
+      if (mEventLastAttempt != 0 && millis() - mEventLastAttempt < 5000) return;
+      mEventLastAttempt = millis();
+      String host = hostPort;
+      uint16_t port = 80;
+      int colon = hostPort.indexOf(':');
+      if (colon > 0) {
+        host = hostPort.substring(0, colon);
+        port = hostPort.substring(colon + 1).toInt();
+      }
+      if (!mEventConnect.start(host, port)) return;
+    }
+    if (mEventConnect.poll(mEventClient) <= 0) return;
+
+    // HTTP/1.0 keeps the server from switching to chunked encoding
+    mEventClient.printf("GET %s HTTP/1.0\r\nHost: %s\r\nAccept: text/event-stream\r\n\r\n",
+                        mEventPath.c_str(), hostPort.c_str());
+    mEventHeadersDone = false;
+    mEventStatusDone = false;
+    mEventLine = "";
+    mEventData = "";
+  }
+
+  while (mEventClient.available() > 0) {
+    int c = mEventClient.read();
+    if (c < 0) break;
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (mEventLine.length() < 256) mEventLine += (char)c;
+      continue;
+    }
+
+    if (!mEventStatusDone) {
+      // "HTTP/1.x 200 OK"; anything else means the server has no event
+      // stream, and asking again would only poll it
+      mEventStatusDone = true;
+      int space = mEventLine.indexOf(' ');
+      int status = mEventLine.startsWith("HTTP/1.") && space > 0 ? mEventLine.substring(space + 1).toInt() : 0;
+      if (status != 200) {
+        LVML_LOGW("Hot reload not offered by %s%s (%s); not asking again", mEventServer.c_str(),
+                  mEventPath.c_str(), mEventLine.c_str());
+        mEventRefused = true;
+        mEventClient.stop();
+        return;
+      }
+      LVML_LOGI("Hot reload connected: %s%s", mEventServer.c_str(), mEventPath.c_str());
+    } else if (!mEventHeadersDone) {
+      // Response headers end with an empty line
+      if (mEventLine.length() == 0) mEventHeadersDone = true;
+    } else if (mEventLine.length() == 0) {
+      // An empty line dispatches the event; each of its lines is a path
+      int start = 0;
+      while (start < (int)mEventData.length()) {
+        int end = mEventData.indexOf('\n', start);
+        if (end < 0) end = mEventData.length();
+        if (end > start) handleChangeEvent(mEventData.substring(start, end));
+        start = end + 1;
+      }
+      mEventData = "";
+    } else if (mEventLine.startsWith("data:")) {
+      // Data lines of one event are joined with newlines
+      String data = mEventLine.substring(5);
+      if (data.startsWith(" ")) data = data.substring(1);
+      if (mEventData.length() + data.length() < 1024) {
+        if (mEventData.length() > 0) mEventData += '\n';
+        mEventData += data;
+      }
+    }
+    mEventLine = "";
+  }
+}
+
+void LVML::handleChangeEvent(const String &path) {
+  String url = path.startsWith("http://") || path.startsWith("https://") ? path : mServerUrl + path;
+
+  if (url == mScreenUrl) {
+    LVML_LOGI("Screen changed on server: %s", path.c_str());
+    loadScreenUrl(mScreenUrl);
+    return;
+  }
+
+  for (const char *imageUrl : mScreenImageUrls) {
+    if (url == imageUrl) {
+      LVML_LOGI("Image changed on server: %s", path.c_str());
+      reloadImage(url);
+      return;
+    }
+  }
+}
+
+bool LVML::reloadImage(const String &url) {
+  auto it = mImageDescriptors.find(generateImageDescriptorName(url));
+  if (it == mImageDescriptors.end()) return false;
+
+  // The replaced pixels stay in the screen arena until the screen is left
+  size_t size = 0;
+  const uint8_t *data = downloadImage(url, &size, mScreenArena);
+  if (!data) return false;
+
+  // Swap the pixels into the registered descriptor so every image using it
+  // picks up the change without touching the widget tree
+  setImageData(it->second, data, size);
+
+  if (mCurrentUi) {
+    lv_obj_invalidate(mCurrentUi);
+  }
+  return true;
+}
+
+//--------------------------------
+// Incremental screen patching
+// Diffs the new preprocessed XML against the one on screen and only touches
+// the widgets whose attributes or subtrees changed
+//--------------------------------
+
+// Widget elements create an object; "parent-child" elements such as
+// lv_event-call_function only configure their parent
+static bool isWidgetElement(tinyxml2::XMLElement* element) {
+  return strchr(element->Name(), '-') == nullptr;
+}
+
+// Two widget elements describe the same object if tag and name match. Both
+// documents share one name table, so equal tags have equal pointers.
+static bool isSameWidget(tinyxml2::XMLElement* a, tinyxml2::XMLElement* b) {
+  if (a->Name() != b->Name()) return false;
+  const char* nameA = a->Attribute("name");
+  const char* nameB = b->Attribute("name");
+  if (!nameA || !nameB) return nameA == nameB;
+  return strcmp(nameA, nameB) == 0;
+}
+
+static String printElement(tinyxml2::XMLElement* element) {
+  tinyxml2::XMLPrinter printer(nullptr, true);
+  element->Accept(&printer);
+  return String(printer.CStr());
+}
+
+bool LVML::patchScreenXml(const LVMLBuffer &xmlContent) {
+  LVML_TRACE_SCOPE("patch");
+  if (xmlContent.equals(mCurrentXml)) {
+    LVML_LOGI("Screen XML unchanged");
+    return true;
+  }
+
+  // mDoc still holds the tree preprocessXmlForImages() printed xmlContent
+  // from, so only the current screen has to be parsed again
+  tinyxml2::XMLDocument &oldDoc = mPatchDoc;
+  tinyxml2::XMLDocument &newDoc = mDoc;
+  if (newDoc.Error() || oldDoc.Parse(mCurrentXml.c_str(), mCurrentXml.length()) != tinyxml2::XML_SUCCESS) {
+    return false;
+  }
+
+  tinyxml2::XMLElement* oldRoot = oldDoc.RootElement();
+  tinyxml2::XMLElement* newRoot = newDoc.RootElement();
+  if (!oldRoot || !newRoot || oldRoot->Name() != newRoot->Name()) {
+    return false;
+  }
+
+  // mCurrentXml was printed with the deferred subtrees cut out, but they
+  // are on display now
+  tinyxml2::XMLElement* currentView = oldRoot->FirstChildElement("view");
+  if (!mLazySubtrees.empty() && (!currentView || !restoreLazySubtrees(currentView))) {
+    return false;
+  }
+
+  // Everything besides the view (consts, styles, api...) lives in the
+  // component scope and can only be changed by registering it again
+  tinyxml2::XMLElement* oldView = nullptr;
+  tinyxml2::XMLElement* newView = nullptr;
+  tinyxml2::XMLElement* oldChild = oldRoot->FirstChildElement();
+  tinyxml2::XMLElement* newChild = newRoot->FirstChildElement();
+  while (oldChild || newChild) {
+    if (!oldChild || !newChild || oldChild->Name() != newChild->Name()) {
+      return false;
+    }
+    if (oldChild->Name() == mViewTag) {
+      oldView = oldChild;
+      newView = newChild;
+    } else if (printElement(oldChild) != printElement(newChild)) {
+      return false;
+    }
+    oldChild = oldChild->NextSiblingElement();
+    newChild = newChild->NextSiblingElement();
+  }
+  if (!oldView || !newView) {
+    return false;
+  }
+
+  const char* oldExtends = oldView->Attribute("extends");
+  const char* newExtends = newView->Attribute("extends");
+  if (strcmp(oldExtends ? oldExtends : "lv_obj", newExtends ? newExtends : "lv_obj") != 0) {
+    return false;
+  }
+
+  return patchElement(mCurrentUi, oldView, newView);
+}
+
+bool LVML::patchElement(lv_obj_t *obj, tinyxml2::XMLElement* oldElement, tinyxml2::XMLElement* newElement) {
+  const char* widgetName = newElement->Name();
+  if (strcmp(widgetName, "view") == 0) {
+    const char* extends = newElement->Attribute("extends");
+    widgetName = extends ? extends : "lv_obj";
+  }
+
+  // Instances of custom components are rebuilt as a whole
+  if (lv_xml_component_get_scope(widgetName) && printElement(oldElement) != printElement(newElement)) {
+    return false;
+  }
+
+  // An attribute that disappeared cannot be reverted to its default in place
+  for (const tinyxml2::XMLAttribute* attr = oldElement->FirstAttribute(); attr; attr = attr->Next()) {
+    if (!newElement->FindAttribute(attr->Name())) {
+      return false;
+    }
+  }
+
+  std::vector<const char*> changed;
+  for (const tinyxml2::XMLAttribute* attr = newElement->FirstAttribute(); attr; attr = attr->Next()) {
+    const char* oldValue = oldElement->Attribute(attr->Name());
+    if (!oldValue || strcmp(oldValue, attr->Value()) != 0) {
+      // Applying "styles" adds styles without removing the old ones
+      if (strcmp(attr->Name(), "styles") == 0) {
+        return false;
+      }
+      changed.push_back(attr->Name());
+      changed.push_back(attr->Value());
+    }
+  }
+
+  // Split children into widgets and the elements configuring this widget
+  std::vector<tinyxml2::XMLElement*> oldWidgets;
+  std::vector<tinyxml2::XMLElement*> newWidgets;
+  String oldConfig;
+  String newConfig;
+  for (tinyxml2::XMLElement* child = oldElement->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    if (isWidgetElement(child)) oldWidgets.push_back(child);
+    else oldConfig += printElement(child);
+  }
+  for (tinyxml2::XMLElement* child = newElement->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    if (isWidgetElement(child)) newWidgets.push_back(child);
+    else newConfig += printElement(child);
+  }
+  if (oldConfig != newConfig) {
+    return false;
+  }
+
+  // Children can only be matched to objects if each widget element created
+  // exactly one child (widgets like lv_tabview create internal children)
+  if (lv_obj_get_child_count(obj) != oldWidgets.size()) {
+    String oldKids;
+    String newKids;
+    for (auto child : oldWidgets) oldKids += printElement(child);
+    for (auto child : newWidgets) newKids += printElement(child);
+    if (oldKids != newKids) {
+      return false;
+    }
+    oldWidgets.clear();
+    newWidgets.clear();
+  }
+
+  if (!changed.empty()) {
+    changed.push_back(nullptr);
+    applyAttributes(obj, widgetName, changed);
+  }
+
+  // Walk both child lists, looking one element ahead to tell insertions
+  // and removals apart from replacements
+  size_t i = 0;
+  size_t j = 0;
+  int32_t index = 0;
+  while (i < oldWidgets.size() || j < newWidgets.size()) {
+    bool haveOld = i < oldWidgets.size();
+    bool haveNew = j < newWidgets.size();
+
+    if (haveOld && haveNew && isSameWidget(oldWidgets[i], newWidgets[j])) {
+      lv_obj_t *child = lv_obj_get_child(obj, index);
+      if (!patchElement(child, oldWidgets[i], newWidgets[j])) {
+        lv_obj_delete(child);
+        lv_obj_t *created = createElement(obj, newWidgets[j]);
+        if (!created) return false;
+        lv_obj_move_to_index(created, index);
+      }
+      index++;
+      i++;
+      j++;
+    } else if (haveOld && j + 1 < newWidgets.size() && isSameWidget(oldWidgets[i], newWidgets[j + 1])) {
+      lv_obj_t *created = createElement(obj, newWidgets[j]);
+      if (!created) return false;
+      lv_obj_move_to_index(created, index);
+      index++;
+      j++;
+    } else if (haveOld && (!haveNew || (i + 1 < oldWidgets.size() && isSameWidget(oldWidgets[i + 1], newWidgets[j])))) {
+      lv_obj_delete(lv_obj_get_child(obj, index));
+      i++;
+    } else {
+      if (haveOld) {
+        lv_obj_delete(lv_obj_get_child(obj, index));
+        i++;
+      }
+      lv_obj_t *created = createElement(obj, newWidgets[j]);
+      if (!created) return false;
+      lv_obj_move_to_index(created, index);
+      index++;
+      j++;
+    }
+  }
+
+  return true;
+}
+
+// Attributes as the NULL-terminated name/value list LVGL's processors take
+static void elementAttributes(tinyxml2::XMLElement* element, std::vector<const char*> &attrs) {
+  for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+    attrs.push_back(attr->Name());
+    attrs.push_back(attr->Value());
+  }
+  attrs.push_back(nullptr);
+}
+
+lv_obj_t* LVML::createElement(lv_obj_t *parent, tinyxml2::XMLElement* element) {
+  std::vector<const char*> attrs;
+  elementAttributes(element, attrs);
+
+  lv_obj_t *item = createWidget(parent, element->Name(), attrs);
+  if (!item) {
+    return nullptr;
+  }
+
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    createElement(item, child);
+  }
+  return item;
+}
+
+lv_obj_t* LVML::createWidget(lv_obj_t *parent, const char *name, std::vector<const char*> &attrs) {
+  // Custom components know how to build themselves
+  if (lv_xml_component_get_scope(name)) {
+    return (lv_obj_t *)lv_xml_create(parent, name, attrs.data());
+  }
+
+  lv_widget_processor_t *processor = lv_xml_widget_get_processor(name);
+  if (!processor) {
+    LVML_LOGW("Unknown widget: %s", name);
+    return nullptr;
+  }
+
+  // Resolve styles and constants against the scope of the screen component
+  lv_xml_parser_state_t state;
+  lv_xml_parser_state_init(&state);
+  state.scope = mCurrentComponent.length() > 0 ? lv_xml_component_get_scope(mCurrentComponent.c_str()) : NULL;
+  state.parent = parent;
+  state.item = parent;
+
+  void *item = processor->create_cb(&state, attrs.data());
+  if (!item) {
+    return nullptr;
+  }
+  state.item = item;
+  processor->apply_cb(&state, attrs.data());
+  return (lv_obj_t *)item;
+}
+
+void LVML::applyAttributes(lv_obj_t *obj, const char *widgetName, std::vector<const char*> &attrs) {
+  lv_widget_processor_t *processor = lv_xml_widget_get_processor(widgetName);
+  if (!processor) {
+    LVML_LOGW("Unknown widget: %s", widgetName);
+    return;
+  }
+
+  lv_xml_parser_state_t state;
+  lv_xml_parser_state_init(&state);
+  state.scope = lv_xml_component_get_scope(mCurrentComponent.c_str());
+  state.parent = lv_obj_get_parent(obj);
+  state.item = obj;
+  processor->apply_cb(&state, attrs.data());
+}
+
+//--------------------------------
+// Progressive building
+// Large screens are created from mDoc breadth first, in time-boxed slices
+// driven by an LVGL timer, so rendering and input continue in between
+//--------------------------------
+static size_t countWidgets(tinyxml2::XMLElement* element) {
+  size_t count = 0;
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    count += (isWidgetElement(child) ? 1 : 0) + countWidgets(child);
+  }
+  return count;
+}
+
+// Plain pixel values only; percentages and "content" are not resolved
+static bool parsePixels(const char *value, int32_t *out) {
+  if (!value || !*value) return false;
+  char *end;
+  long v = strtol(value, &end, 10);
+  if (*end) return false;
+  *out = (int32_t)v;
+  return true;
+}
+
+// Position of an element on the screen: its own x/y plus those of its
+// ancestors up to the view. Fails where an alignment, a layout or a
+// relative size places the element instead, which only LVGL works out.
+// Paddings and borders are left out; they only move children further
+// right and down.
+static bool screenPosition(tinyxml2::XMLElement* element, int32_t* x, int32_t* y) {
+  *x = 0;
+  *y = 0;
+  for (tinyxml2::XMLElement* e = element; e; e = e->Parent() ? e->Parent()->ToElement() : nullptr) {
+    const char* align = e->Attribute("align");
+    if (align && strcmp(align, "top_left") != 0 && strcmp(align, "default") != 0) return false;
+    tinyxml2::XMLElement* parent = e->Parent() ? e->Parent()->ToElement() : nullptr;
+    if (parent && (parent->Attribute("flex_flow") || parent->Attribute("grid_column_dsc_array") ||
+                   parent->Attribute("style_layout"))) {
+      return false;
+    }
+    int32_t offset;
+    const char* ex = e->Attribute("x");
+    const char* ey = e->Attribute("y");
+    if (ex && !parsePixels(ex, &offset)) return false;
+    if (ex) *x += offset;
+    if (ey && !parsePixels(ey, &offset)) return false;
+    if (ey) *y += offset;
+    if (strcmp(e->Name(), "view") == 0) break;
+  }
+  return true;
+}
+
+// Hidden widgets and widgets placed beyond the display: their children are
+// not seen right away and can be built last
+static bool isOutOfSight(tinyxml2::XMLElement* element) {
+  const char* hidden = element->Attribute("hidden");
+  if (hidden && strcmp(hidden, "true") == 0) return true;
+
+  int32_t x, y, w, h;
+  if (!screenPosition(element, &x, &y)) return false;
+  if (x >= lv_display_get_horizontal_resolution(NULL)) return true;
+  if (y >= lv_display_get_vertical_resolution(NULL)) return true;
+  if (parsePixels(element->Attribute("width"), &w) && x + w <= 0) return true;
+  if (parsePixels(element->Attribute("height"), &h) && y + h <= 0) return true;
+  return false;
+}
+
+lv_obj_t* LVML::startBuild(tinyxml2::XMLElement* view) {
+  // The view becomes an object of the type it extends
+  std::vector<const char*> attrs;
+  for (const tinyxml2::XMLAttribute* attr = view->FirstAttribute(); attr; attr = attr->Next()) {
+    if (strcmp(attr->Name(), "extends") == 0) continue;
+    attrs.push_back(attr->Name());
+    attrs.push_back(attr->Value());
+  }
+  attrs.push_back(nullptr);
+  const char* extends = view->Attribute("extends");
+  lv_obj_t *root = createWidget(lv_scr_act(), extends ? extends : "lv_obj", attrs);
+  if (!root) {
+    return nullptr;
+  }
+
+  mBuildStart = millis();
+  mBuildSlices = 0;
+  mBuildWidgets = 1;
+  queueChildren(root, view, false);
+
+  // The first slice runs right away, so the next frame already shows the
+  // top of the screen
+  unsigned long start = micros();
+  if (buildSlice(LVML_BUILD_SLICE_US)) {
+    return root;
+  }
+  LVML_LOGI("First build slice: %u widget(s) in %lu us, %u visible and %u deferred queued",
+            (unsigned)mBuildWidgets, micros() - start, (unsigned)mBuildNow.size(), (unsigned)mBuildLater.size());
+  mBuildTimer = lv_timer_create(buildTimerCallback, 0, this);
+  return root;
+}
+
+void LVML::queueChildren(lv_obj_t *item, tinyxml2::XMLElement* element, bool later) {
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    if (isWidgetElement(child)) {
+      (later ? mBuildLater : mBuildNow).push_back({item, child});
+    } else {
+      // Elements configuring the widget (events, tabs...) are applied now
+      createElement(item, child);
+    }
+  }
+}
+
+void LVML::buildPending(const PendingWidget &pending, bool later) {
+  std::vector<const char*> attrs;
+  elementAttributes(pending.element, attrs);
+  lv_obj_t *item = createWidget(pending.parent, pending.element->Name(), attrs);
+  if (!item) {
+    return;
+  }
+  mBuildWidgets++;
+  queueChildren(item, pending.element, later || isOutOfSight(pending.element));
+}
+
+bool LVML::buildSlice(unsigned long budgetMicros) {
+  LVML_TRACE_SCOPE("build_slice");
+  unsigned long start = micros();
+  mBuildSlices++;
+  do {
+    bool later = mBuildNow.empty();
+    std::deque<PendingWidget> &queue = later ? mBuildLater : mBuildNow;
+    if (queue.empty()) break;
+    PendingWidget pending = queue.front();
+    queue.pop_front();
+    buildPending(pending, later);
+  } while (micros() - start < budgetMicros);
+
+  if (!mBuildNow.empty() || !mBuildLater.empty()) {
+    return false;
+  }
+  LVML_LOGI("Screen built: %u widget(s) in %u slice(s), %lu ms",
+            (unsigned)mBuildWidgets, (unsigned)mBuildSlices, millis() - mBuildStart);
+  attachLazySubtrees();
+  return true;
+}
+
+void LVML::buildTimerCallback(lv_timer_t *timer) {
+  LVML *self = (LVML *)lv_timer_get_user_data(timer);
+  if (self->buildSlice(LVML_BUILD_SLICE_US)) {
+    lv_timer_delete(timer);
+    self->mBuildTimer = nullptr;
+  }
+}
+
+void LVML::finishBuild() {
+  if (!mBuildTimer) return;
+  buildSlice((unsigned long)-1);
+  lv_timer_delete(mBuildTimer);
+  mBuildTimer = nullptr;
+}
+
+void LVML::cancelBuild() {
+  mBuildNow.clear();
+  mBuildLater.clear();
+  if (mBuildTimer) {
+    lv_timer_delete(mBuildTimer);
+    mBuildTimer = nullptr;
+  }
+}
+
+//--------------------------------
+// Shared styles
+// Inline style_* attributes give each object its own local style
+// properties. Sets that repeat across a screen are moved into a <style> of
+// the component, so LVGL keeps one lv_style_t that all those objects share.
+//--------------------------------
+
+// Style attributes for the default part and state; selectors such as
+// style_bg_color:pressed stay inline
+static bool isSharableStyle(const char *name) {
+  return strncmp(name, "style_", 6) == 0 && !strchr(name, ':');
+}
+
+// Pairs every widget with its inline style set, as sorted "name=value" lines
+void LVML::collectStyleSets(tinyxml2::XMLElement* element, std::vector<std::pair<tinyxml2::XMLElement*, String>> &sets) {
+  std::vector<const tinyxml2::XMLAttribute*> styles;
+  for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+    if (isSharableStyle(attr->Name())) styles.push_back(attr);
+  }
+  if (!styles.empty()) {
+    std::sort(styles.begin(), styles.end(), [](const tinyxml2::XMLAttribute* a, const tinyxml2::XMLAttribute* b) {
+      return strcmp(a->Name(), b->Name()) < 0;
+    });
+    String key;
+    for (const tinyxml2::XMLAttribute* attr : styles) {
+      key += attr->Name();
+      key += '=';
+      key += attr->Value();
+      key += '\n';
+    }
+    sets.push_back({element, key});
+  }
+
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    if (isWidgetElement(child)) collectStyleSets(child, sets);
+  }
+}
+
+void LVML::shareStyles(tinyxml2::XMLElement* root, tinyxml2::XMLElement* view) {
+  LVML_TRACE_SCOPE("share_styles");
+  std::vector<std::pair<tinyxml2::XMLElement*, String>> sets;
+  collectStyleSets(view, sets);
+
+  std::map<String, size_t> uses;
+  for (const auto &set : sets) uses[set.second]++;
+
+  // Shared styles are named in order of first use, so reloading the same
+  // screen gives the same component
+  std::map<String, String> names;
+  tinyxml2::XMLElement* stylesElement = nullptr;
+  size_t rewritten = 0;
+  size_t properties = 0;
+  for (const auto &set : sets) {
+    tinyxml2::XMLElement* element = set.first;
+    if (uses[set.second] < LVML_SHARED_STYLE_MIN_USES) continue;
+
+    auto named = names.find(set.second);
+    if (named == names.end()) {
+      if (!stylesElement) {
+        stylesElement = root->FirstChildElement("styles");
+      }
+      if (!stylesElement) {
+        // After <consts>, which the styles may refer to
+        stylesElement = root->GetDocument()->NewElement("styles");
+        tinyxml2::XMLNode* before = view->PreviousSibling();
+        if (before) root->InsertAfterChild(before, stylesElement);
+        else root->InsertFirstChild(stylesElement);
+      }
+      String name = "lvml_s" + String((int)names.size());
+      tinyxml2::XMLElement* style = root->GetDocument()->NewElement("style");
+      style->SetAttribute("name", name.c_str());
+      for (const tinyxml2::XMLAttribute* attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+        if (isSharableStyle(attr->Name())) style->SetAttribute(attr->Name() + 6, attr->Value());
+      }
+      stylesElement->InsertEndChild(style);
+      named = names.insert({set.second, name}).first;
+    }
+
+    // Added last, the shared style still overrides the widget's other styles
+    const char* existing = element->Attribute("styles");
+    String styles = existing ? String(existing) + " " + named->second : named->second;
+    const tinyxml2::XMLAttribute* attr = element->FirstAttribute();
+    while (attr) {
+      const tinyxml2::XMLAttribute* next = attr->Next();
+      if (isSharableStyle(attr->Name())) {
+        element->DeleteAttribute(attr->Name());
+        properties++;
+      }
+      attr = next;
+    }
+    element->SetAttribute("styles", styles.c_str());
+    rewritten++;
+  }
+
+  if (!names.empty()) {
+    LVML_LOGI("Shared styles: %d style(s) replace %d properties on %d widget(s)",
+              (int)names.size(), (int)properties, (int)rewritten);
+  }
+}
+
+//--------------------------------
+// Lazy subtrees
+// Children nobody sees yet are printed into slices and removed from the
+// screen before it is created. Their placeholder builds them from the slice
+// when it is first drawn.
+//--------------------------------
+static bool hasWidgetChildren(tinyxml2::XMLElement* element) {
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    if (isWidgetElement(child)) return true;
+  }
+  return false;
+}
+
+// A content-sized placeholder has no size without its children, so it
+// would never be drawn and never build them
+static bool isContentSized(tinyxml2::XMLElement* element) {
+  const char* width = element->Attribute("width");
+  const char* height = element->Attribute("height");
+  return (width && strcmp(width, "content") == 0) || (height && strcmp(height, "content") == 0);
+}
+
+void LVML::collectLazySubtrees(tinyxml2::XMLElement* element, bool inLazy) {
+  int tab = 0;
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    bool isTab = strcmp(child->Name(), "lv_tabview-tab") == 0;
+    const char* lazyAttr = child->Attribute("lazy");
+    bool implicit = mLazyBuild && (isOutOfSight(child) ||
+                                   (isTab && tab > 0 && strcmp(element->Name(), "lv_tabview") == 0));
+    bool lazy = !inLazy && hasWidgetChildren(child) && !isContentSized(child) &&
+                ((lazyAttr && strcmp(lazyAttr, "true") == 0) || implicit);
+
+    // "lazy" is LVML's own attribute; LVGL must not see it
+    child->DeleteAttribute("lazy");
+    collectLazySubtrees(child, inLazy || lazy);
+    if (lazy) {
+      if (isTab) {
+        deferChildren(child, element, tab);
+      } else {
+        deferChildren(child, child, -1);
+      }
+    }
+    if (isTab) tab++;
+  }
+}
+
+void LVML::deferChildren(tinyxml2::XMLElement* element, tinyxml2::XMLElement* named, int tab) {
+  // The placeholder (or its tabview) is found again by name
+  if (!named->Attribute("name")) {
+    named->SetAttribute("name", ("lvml_lazy_" + String(mLazyCounter++)).c_str());
+  }
+
+  LazySubtree subtree;
+  subtree.name = mLoadingArena.copyString(named->Attribute("name"));
+  subtree.tab = tab;
+  subtree.widgets = 0;
+  subtree.placeholder = nullptr;
+  subtree.built = false;
+
+  // Widget children move into the slice; elements configuring the
+  // placeholder itself stay. The slice is printed into a reused buffer and
+  // kept in the screen arena.
+  mLazyScratch.rewind();
+  LVMLBufferPrinter printer(mLazyScratch, true);
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    if (isWidgetElement(child)) {
+      child->Accept(&printer);
+      subtree.widgets += 1 + countWidgets(child);
+    }
+  }
+  subtree.xml = mLoadingArena.copyString(mLazyScratch.c_str(), mLazyScratch.length());
+  subtree.length = mLazyScratch.length();
+  if (!subtree.name || !subtree.xml) {
+    // Out of arena: the children stay and are created with the screen
+    return;
+  }
+
+  tinyxml2::XMLElement* child = element->FirstChildElement();
+  while (child) {
+    tinyxml2::XMLElement* next = child->NextSiblingElement();
+    if (isWidgetElement(child)) {
+      element->DeleteChild(child);
+    }
+    child = next;
+  }
+  mLoadingLazy.push_back(subtree);
+}
+
+void LVML::attachLazySubtrees() {
+  for (size_t i = 0; i < mLazySubtrees.size(); i++) {
+    LazySubtree &subtree = mLazySubtrees[i];
+    lv_obj_t *obj = lv_obj_find_by_name(mCurrentUi, subtree.name);
+    if (obj && subtree.tab >= 0) {
+      obj = lv_obj_get_child(lv_tabview_get_content(obj), subtree.tab);
+    }
+    if (!obj) {
+      LVML_LOGW("Lazy subtree %s: placeholder not found", subtree.name);
+      continue;
+    }
+    subtree.placeholder = obj;
+    lv_obj_add_event_cb(obj, lazyDrawCallback, LV_EVENT_DRAW_MAIN_BEGIN, (void *)(uintptr_t)i);
+  }
+}
+
+void LVML::releaseLazySubtrees() {
+  for (size_t i = 0; i < mLazySubtrees.size(); i++) {
+    lv_async_call_cancel(lazyExpandAsync, (void *)(uintptr_t)i);
+  }
+  mLazySubtrees.clear();
+}
+
+void LVML::lazyDrawCallback(lv_event_t *e) {
+  // Children cannot be created while the parent is being drawn
+  lv_obj_remove_event_cb(lv_event_get_current_target_obj(e), lazyDrawCallback);
+  lv_async_call(lazyExpandAsync, lv_event_get_user_data(e));
+}
+
+void LVML::lazyExpandAsync(void *data) {
+  if (mInstance) {
+    mInstance->expandLazySubtree((size_t)(uintptr_t)data);
+  }
+}
+
+void LVML::expandLazySubtree(size_t index) {
+  LVML_TRACE_SCOPE("lazy_expand");
+  if (index >= mLazySubtrees.size()) return;
+  LazySubtree &subtree = mLazySubtrees[index];
+  if (!subtree.placeholder || subtree.built || !lv_obj_is_valid(subtree.placeholder)) return;
+  lv_obj_remove_event_cb(subtree.placeholder, lazyDrawCallback);
+
+  unsigned long start = micros();
+  tinyxml2::XMLDocument &doc = mPatchDoc;
+  if (doc.Parse(subtree.xml, subtree.length) != tinyxml2::XML_SUCCESS) {
+    LVML_LOGW("Lazy subtree %s: %s", subtree.name, doc.ErrorStr());
+    return;
+  }
+  for (tinyxml2::XMLElement* child = doc.FirstChildElement(); child; child = child->NextSiblingElement()) {
+    createElement(subtree.placeholder, child);
+  }
+  subtree.built = true;
+  LVML_LOGI("Lazy subtree %s built: %d widget(s) in %lu us", subtree.name,
+            (int)subtree.widgets, micros() - start);
+}
+
+void LVML::expandLazySubtrees() {
+  for (size_t i = 0; i < mLazySubtrees.size(); i++) {
+    expandLazySubtree(i);
+  }
+}
+
+lv_obj_t* LVML::findWidget(const char *name) {
+  if (!mCurrentUi) return nullptr;
+  lv_obj_t *obj = lv_obj_find_by_name(mCurrentUi, name);
+  if (obj) return obj;
+
+  // The widget may still wait in the slice of a deferred subtree
+  String attribute = String(" name=\"") + name + "\"";
+  for (size_t i = 0; i < mLazySubtrees.size(); i++) {
+    const LazySubtree &subtree = mLazySubtrees[i];
+    if (!subtree.built && strstr(subtree.xml, attribute.c_str())) {
+      expandLazySubtree(i);
+      return lv_obj_find_by_name(mCurrentUi, name);
+    }
+  }
+  return nullptr;
+}
+
+static tinyxml2::XMLElement* findElementByName(tinyxml2::XMLElement* element, const char *name) {
+  for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    const char* childName = child->Attribute("name");
+    if (childName && strcmp(childName, name) == 0) return child;
+    tinyxml2::XMLElement* found = findElementByName(child, name);
+    if (found) return found;
+  }
+  return nullptr;
+}
+
+bool LVML::restoreLazySubtrees(tinyxml2::XMLElement* view) {
+  for (const LazySubtree &subtree : mLazySubtrees) {
+    if (!subtree.built) continue;
+    tinyxml2::XMLElement* named = findElementByName(view, subtree.name);
+    tinyxml2::XMLElement* element = named;
+    if (named && strncmp(subtree.name, "lvml_lazy_", 10) == 0) {
+      // Names made up by deferChildren() are not in the reloaded XML
+      named->DeleteAttribute("name");
+    }
+    if (element && subtree.tab >= 0) {
+      element = element->FirstChildElement("lv_tabview-tab");
+      for (int skip = 0; element && skip < subtree.tab; skip++) {
+        element = element->NextSiblingElement("lv_tabview-tab");
+      }
+    }
+    tinyxml2::XMLDocument slice;
+    if (!element || slice.Parse(subtree.xml, subtree.length) != tinyxml2::XML_SUCCESS) {
+      return false;
+    }
+    for (tinyxml2::XMLElement* child = slice.FirstChildElement(); child; child = child->NextSiblingElement()) {
+      element->InsertEndChild(child->DeepClone(view->GetDocument()));
+    }
+  }
+  return true;
+}
+
+//--------------------------------
+// Compiled screens
+// Widgets are created straight from the binary form built by tools/lvmlc;
+// common typed attributes are applied with direct setters
+//--------------------------------
+void LVML::loadScreenCompiled(const uint8_t *data, size_t size) {
+  LVML_TRACE_SCOPE("load_compiled");
+  LVMLCompiledReader reader;
+  uint16_t stringCount = 0;
+  if (!lvmlCompiledOpen(&reader, data, size, &stringCount)) {
+    discardScreenArena();
+    LVML_LOGW("Invalid compiled screen");
+    return;
+  }
+  std::vector<const char*> strings(stringCount);
+  if (!lvmlCompiledStrings(&reader, strings.data(), stringCount)) {
+    discardScreenArena();
+    LVML_LOGW("Invalid compiled screen strings");
+    return;
+  }
+
+  // Remove the current UI
+  cancelBuild();
+  releaseLazySubtrees();
+  if (mCurrentUi) {
+    lv_obj_del(mCurrentUi);
+    mCurrentUi = nullptr;
+  }
+
+  // Compiled screens have no component scope and are not patched
+  unregisterComponent(mCurrentComponent);
+  mCurrentComponent = "";
+  mCurrentXml.clear();
+  mLoadingImageUrls.clear();
+
+  mCurrentUi = createCompiledNode(&reader, strings, lv_scr_act());
+  if (mCurrentUi && !reader.error) {
+    mScreenUrl = mCurrentUrl;
+    LVML_LOGI("Compiled screen loaded successfully!");
+  } else {
+    mScreenUrl = "";
+    LVML_LOGW("Failed to create compiled screen");
+  }
+  sampleLoadMemory(LVML_PHASE_CREATE);
+  markLoadStage(LVML_STAGE_CREATE);
+  commitScreenArena();
+
+  onLoadScreen();
+}
+
+lv_obj_t* LVML::createCompiledNode(LVMLCompiledReader *reader, const std::vector<const char*> &strings, lv_obj_t *parent) {
+  uint16_t tag, attrCount, childCount;
+  if (!lvmlCompiledNode(reader, &tag, &attrCount, &childCount) || tag >= strings.size()) {
+    reader->error = true;
+    return nullptr;
+  }
+
+  std::vector<LVMLCompiledAttr> typed;
+  std::vector<const char*> attrs;
+  std::vector<String> text;
+  attrs.reserve(attrCount * 2 + 1);
+  text.reserve(attrCount);
+  for (uint16_t i = 0; i < attrCount; i++) {
+    LVMLCompiledAttr attr;
+    if (!lvmlCompiledAttr(reader, &attr) || attr.name >= strings.size()) {
+      reader->error = true;
+      return nullptr;
+    }
+    const char *name = strings[attr.name];
+
+    switch (attr.type) {
+      case LVMLC_STRING:
+        if (attr.value >= strings.size()) {
+          reader->error = true;
+          return nullptr;
+        }
+        attrs.push_back(name);
+        if (strncmp(name, "bind_", 5) == 0) {
+          text.push_back(ensureSubject(name, String(strings[attr.value])));
+          attrs.push_back(text.back().c_str());
+        } else {
+          attrs.push_back(strings[attr.value]);
+        }
+        break;
+      case LVMLC_IMAGE: {
+        if (attr.value >= strings.size()) {
+          reader->error = true;
+          return nullptr;
+        }
+        String fullUrl = mServerUrl + strings[attr.value];
+        const char *storedUrl = mLoadingArena.copyString(fullUrl);
+        if (storedUrl) {
+          mLoadingImageUrls.push_back(storedUrl);
+        }
+        text.push_back(loadImage(fullUrl));
+        attrs.push_back(name);
+        attrs.push_back(text.back().c_str());
+        break;
+      }
+      default:
+        typed.push_back(attr);
+        break;
+    }
+  }
+
+  // Typed values without a direct setter go through LVGL's parser as text
+  lv_obj_t *obj = nullptr;
+  std::vector<LVMLCompiledAttr> direct;
+  for (const LVMLCompiledAttr &attr : typed) {
+    const char *name = strings[attr.name];
+    if (applyCompiledAttr(nullptr, name, attr)) {
+      direct.push_back(attr);
+      continue;
+    }
+    char buf[16];
+    switch (attr.type) {
+      case LVMLC_INT: snprintf(buf, sizeof(buf), "%d", (int)(int32_t)attr.value); break;
+      case LVMLC_PERCENT: snprintf(buf, sizeof(buf), "%d%%", (int)(int32_t)attr.value); break;
+      case LVMLC_CONTENT: snprintf(buf, sizeof(buf), "content"); break;
+      default: snprintf(buf, sizeof(buf), "0x%06X", (unsigned)attr.value); break;
+    }
+    text.push_back(String(buf));
+    attrs.push_back(name);
+    attrs.push_back(text.back().c_str());
+  }
+  attrs.push_back(nullptr);
+
+  if (parent) {
+    obj = createWidget(parent, strings[tag], attrs);
+  }
+  if (obj) {
+    for (const LVMLCompiledAttr &attr : direct) {
+      applyCompiledAttr(obj, strings[attr.name], attr);
+    }
+  }
+
+  // Children are always read so the cursor stays in sync
+  for (uint16_t i = 0; i < childCount; i++) {
+    createCompiledNode(reader, strings, obj);
+  }
+  return obj;
+}
+
+// Applies typed attributes that have a direct LVGL setter. With obj == nullptr
+// it only reports whether the attribute would be handled.
+bool LVML::applyCompiledAttr(lv_obj_t *obj, const char *name, const LVMLCompiledAttr &attr) {
+  int32_t value = (int32_t)attr.value;
+  int32_t size = attr.type == LVMLC_PERCENT ? lv_pct(value) : attr.type == LVMLC_CONTENT ? LV_SIZE_CONTENT : value;
+  bool isSize = attr.type == LVMLC_INT || attr.type == LVMLC_PERCENT;
+
+  if (strcmp(name, "x") == 0 && isSize) {
+    if (obj) lv_obj_set_x(obj, size);
+  } else if (strcmp(name, "y") == 0 && isSize) {
+    if (obj) lv_obj_set_y(obj, size);
+  } else if (strcmp(name, "width") == 0 && (isSize || attr.type == LVMLC_CONTENT)) {
+    if (obj) lv_obj_set_width(obj, size);
+  } else if (strcmp(name, "height") == 0 && (isSize || attr.type == LVMLC_CONTENT)) {
+    if (obj) lv_obj_set_height(obj, size);
+  } else if (strcmp(name, "style_bg_color") == 0 && attr.type == LVMLC_COLOR) {
+    if (obj) lv_obj_set_style_bg_color(obj, lv_color_hex(attr.value), 0);
+  } else if (strcmp(name, "style_text_color") == 0 && attr.type == LVMLC_COLOR) {
+    if (obj) lv_obj_set_style_text_color(obj, lv_color_hex(attr.value), 0);
+  } else if (strcmp(name, "style_radius") == 0 && attr.type == LVMLC_INT) {
+    if (obj) lv_obj_set_style_radius(obj, value, 0);
+  } else if (strcmp(name, "style_pad_all") == 0 && attr.type == LVMLC_INT) {
+    if (obj) lv_obj_set_style_pad_all(obj, value, 0);
+  } else if (strcmp(name, "style_border_width") == 0 && attr.type == LVMLC_INT) {
+    if (obj) lv_obj_set_style_border_width(obj, value, 0);
+  } else {
+    return false;
+  }
+  return true;
 }
 
 //--------------------------------
@@ -296,17 +2035,17 @@ void LVML::cleanupImageDescriptors() {
 //--------------------------------
 void LVML::loadScreenCallback(lv_event_t * e) {
   if (!mInstance) {
-    Serial.println("No LVML instance available!");
+    LVML_LOGE("No LVML instance available!");
     return;
   }
   
   const char * target_data = (const char *)lv_event_get_user_data(e);
   if (!target_data) {
-    Serial.println("No target specified!");
+    LVML_LOGW("No target specified!");
     return;
   }
   
-  Serial.printf("Loading target: %s\n", target_data);
+  LVML_LOGD("Loading target: %s", target_data);
   
   String fullUrl;
   String target(target_data);
@@ -336,5 +2075,34 @@ void LVML::loadScreenCallback(lv_event_t * e) {
     }
   }
   
-  mInstance->loadScreenUrl(fullUrl);
+  mInstance->navigateTo(fullUrl);
+}
+
+// Taps arrive inside LVGL event handlers, on widgets of the screen a load
+// deletes, so the load runs once the handler has returned. Taps before it
+// runs are merged into one load of the last target.
+void LVML::navigateTo(const String &url) {
+  if (mPendingUrl.length() > 0) {
+    mCoalescedNavigations++;
+    LVML_LOGI("Navigation to %s replaces pending %s", url.c_str(), mPendingUrl.c_str());
+  } else {
+    mNavigationStart = millis();
+    lv_async_call(pendingLoadAsync, this);
+  }
+  mPendingUrl = url;
+}
+
+void LVML::pendingLoadAsync(void *data) {
+  LVML *lvml = (LVML*)data;
+  String url = lvml->mPendingUrl;
+  lvml->mPendingUrl = "";
+  lvml->loadScreenUrl(url);
+  lvml->mLastNavigationMs = millis() - lvml->mNavigationStart;
+  lvml->mNavigations++;
+}
+
+void LVML::unregisterComponent(const String &name) {
+  if (name.length() == 0) return;
+  lv_xml_component_unregister(name.c_str());
+  mComponentCount--;
 }
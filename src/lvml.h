@@ -3,11 +3,62 @@
 #include <lvgl.h>
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include <algorithm>
+#include <deque>
 #include <map>
+#include <vector>
 #include <tinyxml2.h>
 
+#include "lvml_arena.h"
+#include "lvml_buffer.h"
+#include "lvml_bundle.h"
+#include "lvml_compiled.h"
+#include "lvml_connect.h"
+#include "lvml_inflate.h"
+#include "lvml_log.h"
+#include "lvml_memory.h"
+#include "lvml_metrics.h"
+#include "lvml_prefetch.h"
+#include "lvml_trace.h"
+#include "lvml_xml_scanner.h"
+
 #include "misc/lv_types.h"
 #include "others/xml/lv_xml_component.h"
+#include "others/xml/lv_xml_parser.h"
+#include "others/xml/lv_xml_widget.h"
+
+// PSRAM reserved for the node pools of the XML parse documents
+#ifndef LVML_XML_ARENA_SIZE
+#define LVML_XML_ARENA_SIZE (64 * 1024)
+#endif
+
+// Node pool block size of the parse documents; screens are small, so blocks
+// smaller than tinyxml2's 4 KB default leave less of the arena unused
+#ifndef LVML_XML_BLOCK_SIZE
+#define LVML_XML_BLOCK_SIZE 1024
+#endif
+
+// Identical inline style sets used by at least this many widgets of a screen
+// are moved into one shared style
+#ifndef LVML_SHARED_STYLE_MIN_USES
+#define LVML_SHARED_STYLE_MIN_USES 2
+#endif
+
+// Screens with at least this many widgets are built progressively, in
+// slices of at most LVML_BUILD_SLICE_US per lv_timer_handler() call
+#ifndef LVML_PROGRESSIVE_MIN_WIDGETS
+#define LVML_PROGRESSIVE_MIN_WIDGETS 48
+#endif
+
+#ifndef LVML_BUILD_SLICE_US
+#define LVML_BUILD_SLICE_US 8000
+#endif
+
+// Longest data channel line; longer ones are cut and logged. String
+// subjects hold a whole line, so no value is truncated beyond that.
+#ifndef LVML_DATA_LINE_MAX
+#define LVML_DATA_LINE_MAX 256
+#endif
 
 class LVML {
   public:
@@ -15,9 +66,12 @@ class LVML {
     ~LVML(); // Destructor
     
     void begin();
-    void loadScreenXml(String xmlContent);
+    void loadScreenXml(const String &xmlContent);
+    void loadScreenXml(LVMLBuffer &&xmlContent);
+    void loadScreenCompiled(const uint8_t *data, size_t size);
     void loadScreenUrl(String url);
-    String loadXMLFromURL(String url);
+    LVMLBuffer loadXMLFromURL(const String &url);
+    LVMLBuffer loadBundleFromURL(const String &url);
     
     // Static callback that can access instance data
     static void loadScreenCallback(lv_event_t * e);
@@ -27,25 +81,316 @@ class LVML {
 
     void onLoadScreen();
 
+    // When enabled, reloading the URL that is currently on screen patches the
+    // existing widgets instead of rebuilding the whole tree (default: on)
+    void setPatchMode(bool enabled);
+
+    // When enabled, a request for "screen.xml" first tries the precompiled
+    // "screen.lvmlc" built by tools/lvmlc and falls back to the XML
+    void setPreferCompiled(bool enabled);
+
+    // When enabled, image sources are picked out of the screen XML while it
+    // downloads and fetched on a background task, overlapping image and XML
+    // transfers (default: on)
+    void setPrefetchImages(bool enabled);
+
+    // When enabled, large screens are created across several LVGL timer
+    // ticks, top-level and visible widgets first, so the first frame shows
+    // up before the whole tree exists (default: on)
+    void setProgressiveBuild(bool enabled);
+
+    // The children of widgets marked lazy="true" are always cut from the
+    // screen and only created when their parent is first drawn, i.e. shown
+    // or scrolled into view. When enabled, so are those of hidden or
+    // offscreen widgets and of all but the first tab of a tabview (default:
+    // off). Content-sized widgets are never deferred; they would not be
+    // drawn without their children.
+    void setLazyBuild(bool enabled);
+
+    // When enabled, identical sets of inline style_* attributes are rewritten
+    // to reference one shared style of the screen, instead of giving every
+    // widget its own local style properties (default: off). Shared styles are
+    // numbered in order of use, so most edits of a screen rename them and
+    // its reload is rebuilt rather than patched; enable this for screens
+    // that are not edited while shown.
+    void setShareStyles(bool enabled);
+
+    // Memory each URL cost when loadScreenUrl() last loaded it (use after
+    // preprocess, create and release relative to before the fetch) and the
+    // highest peaks over all its loads
+    const std::map<String, LVMLScreenMemory>& screenMemory() const { return mScreenMemory; }
+
+    // Loads url the way a load_screen tap does: after the current LVGL
+    // event has been handled, with requests made before that merged into one
+    // load of the last url. Safe to call from event handlers (e.g. a Back key).
+    void navigateTo(const String &url);
+
+    // load_screen navigation: loads done, taps merged into a load that was
+    // still pending, and tap-to-screen time of the last load
+    uint32_t navigations() const { return mNavigations; }
+    uint32_t coalescedNavigations() const { return mCoalescedNavigations; }
+    unsigned long lastNavigationMs() const { return mLastNavigationMs; }
+
+    // Screen components registered with LVGL and image descriptors held;
+    // both should stay flat however long the user navigates
+    size_t componentCount() const { return mComponentCount; }
+    size_t imageDescriptorCount() const { return mImageDescriptors.size(); }
+
+    // Live data channel: a TCP server pushes "key=value" lines which update
+    // bound subjects (bind_text="key", bind_value="key") or named widgets.
+    // The connection is made without blocking the loop; a key may be bound
+    // as text and as a number, each kind gets its own subject.
+    void beginDataChannel(const String &host, uint16_t port);
+    void setValue(const String &key, const String &value);
+
+    // Hot reload: hold one server-sent events connection to the server and
+    // reload (patch) the current screen or its images when they change.
+    // Connects without blocking the loop; a server that answers anything
+    // but 200 is not asked again until navigation leads to another server.
+    void beginHotReload(const String &eventPath = "/__lvml/events");
+
+    // Call from the main loop to service the data channel and hot reload
+    void loop();
+
   private:
+    // Subject registered for a bound key, with storage for string values
+    struct DataSubject {
+      lv_subject_t subject;
+      bool isString;
+      char buf[LVML_DATA_LINE_MAX];
+      char prevBuf[LVML_DATA_LINE_MAX];
+    };
+
+    // Queues image downloads for lv_image tags while the XML streams in
+    class ImagePrefetchListener : public LVMLXmlListener {
+      public:
+        explicit ImagePrefetchListener(LVML *owner) : mOwner(owner) {}
+        void startElement(const char *name, const char *const *attrs, size_t count) override;
+
+      private:
+        LVML *mOwner;
+    };
+
+    // Image entries of a downloaded bundle; the bundle and this table live
+    // in the loading screen's arena, and descriptors point straight into it
+    struct ScreenBundle {
+      const LVMLBundleEntry *entries = nullptr;
+      size_t count = 0;
+    };
+
     String mServerUrl;
     String mCurrentUrl;
     lv_obj_t *mCurrentUi;
     int screen_counter;
+
+    // Preprocessed XML, component name and URL of the screen currently shown
+    LVMLBuffer mCurrentXml;
+    String mCurrentComponent;
+    String mScreenUrl;
+    bool mPatchMode;
+    bool mPreferCompiled;
+    bool mPrefetchImages;
+    bool mProgressiveBuild;
+    bool mLazyBuild;
+    bool mShareStyles;
+    size_t mComponentCount;
+
+    // Navigation requested by a load_screen tap, loaded asynchronously
+    String mPendingUrl;
+    unsigned long mNavigationStart;
+    unsigned long mLastNavigationMs;
+    uint32_t mNavigations;
+    uint32_t mCoalescedNavigations;
+
+    // Long-lived parse documents (new screen and, for patching, the current
+    // one) whose node pools are carved from a PSRAM arena and reused. Both
+    // intern names in one table, so tags compare by pointer across them.
+    // The table grows by reallocating its slots, so it uses the PSRAM
+    // allocator, not the arena, which never frees.
+    LVMLPsramAllocator mPsramAllocator;
+    LVMLPsramBlock mXmlArenaMemory;
+    tinyxml2::XMLArena mXmlArena;
+    tinyxml2::XMLNameTable mXmlNames;
+    tinyxml2::XMLDocument mDoc;
+    tinyxml2::XMLDocument mPatchDoc;
+    const char *mImageTag;
+    const char *mViewTag;
     
     // Static pointer to the current instance
     static LVML* mInstance;
     
-    // Storage for downloaded image descriptors
+    // Memory owned by the screen on display and by the one being loaded.
+    // A load ends by swapping them and resetting the loading arena, which
+    // then holds the previous screen, or by resetting it if the load failed.
+    LVMLArena mScreenArena;
+    LVMLArena mLoadingArena;
+
+    // Image descriptors registered with LVGL stay valid for the session
+    // (names cannot be registered again), so they come from an arena that
+    // is never reset; their pixels belong to the screen arenas
+    LVMLArena mSessionArena;
     std::map<String, lv_image_dsc_t*> mImageDescriptors;
     
+    // Subjects created for bind_* attributes by subject name (the key for
+    // bind_text, the key plus "#value" for numeric bindings), kept for the
+    // whole session
+    std::map<String, DataSubject*> mSubjects;
+
+    // Data channel connection state
+    WiFiClient mDataClient;
+    LVMLAsyncConnect mDataConnect;
+    String mDataHost;
+    uint16_t mDataPort;
+    unsigned long mDataLastAttempt;
+    String mDataLine;
+    bool mDataLineCut;
+
+    // Hot reload connection state
+    WiFiClient mEventClient;
+    LVMLAsyncConnect mEventConnect;
+    String mEventPath;
+    String mEventServer;
+    unsigned long mEventLastAttempt;
+    bool mEventHeadersDone;
+    bool mEventStatusDone;
+    bool mEventRefused;
+    String mEventLine;
+    String mEventData;
+
+    // Images used by the screen currently shown, for hot reload, and by the
+    // one being loaded; the URLs live in the screen arenas
+    std::vector<const char*> mScreenImageUrls;
+    std::vector<const char*> mLoadingImageUrls;
+
+    // Bundle of the screen being loaded (empty for plain XML screens)
+    ScreenBundle mBundle;
+
+    // Memory sampled during the load in progress, and per URL
+    LVMLLoadTracker mLoadMemory;
+    LVMLHeapStats mLvglHeap;  // LVGL's pool at the last load phase sampled
+    std::map<String, LVMLScreenMemory> mScreenMemory;
+
+    // Timing of the load in progress for the load histograms: start, end of
+    // the last stage (0 when no load is timed) and a bit per stage reached
+    unsigned long mLoadStart;
+    unsigned long mStageMark;
+    uint8_t mStagesDone;
+
+    // Image downloads started while the screen XML was still arriving
+    LVMLImagePrefetcher mPrefetcher;
+
+    // Progressive build of the current screen: widget elements of mDoc still
+    // to create, breadth first. Children of hidden or offscreen widgets wait
+    // in mBuildLater until everything visible exists.
+    struct PendingWidget {
+      lv_obj_t *parent;
+      tinyxml2::XMLElement *element;
+    };
+    std::deque<PendingWidget> mBuildNow;
+    std::deque<PendingWidget> mBuildLater;
+    lv_timer_t *mBuildTimer;
+    unsigned long mBuildStart;
+    uint32_t mBuildSlices;
+    uint32_t mBuildWidgets;
+
+    // Deferred subtree: the printed widget children of a placeholder object,
+    // found by name once the screen exists (for tabs: the tabview's name and
+    // the tab's index)
+    struct LazySubtree {
+      const char *name;
+      int tab;
+      const char *xml;      // in the screen arena
+      size_t length;
+      size_t widgets;
+      lv_obj_t *placeholder;
+      bool built;
+    };
+    std::vector<LazySubtree> mLazySubtrees;   // screen currently shown
+    std::vector<LazySubtree> mLoadingLazy;    // screen being loaded
+    int mLazyCounter;
+    LVMLBuffer mLazyScratch;
+
+    // Helper methods for screen arenas
+    void commitScreenArena();
+    void discardScreenArena();
+    void resetScreenArena(LVMLArena &arena);
+
+    // Helper methods for navigation
+    static void pendingLoadAsync(void *data);
+    void unregisterComponent(const String &name);
+
+    // Helper methods for memory tracking
+    void sampleLoadMemory(LVMLLoadPhase phase);
+    void finishLoadMemory();
+
+    // Helper methods for load metrics
+    void markLoadStage(LVMLLoadStage stage);
+    void finishLoadStages();
+
     // Helper methods for image handling
-    lv_image_dsc_t* downloadImageToDescriptor(const String &url);
+    static uint8_t* downloadToBuffer(const String &url, size_t *size, bool psram);
+    static uint8_t* downloadTo(const String &url, size_t *size, bool psram, LVMLArena *arena);
+    lv_image_dsc_t* createImageDescriptor(const uint8_t *data, uint32_t size);
+    const uint8_t* downloadImage(const String &url, size_t *size, LVMLArena &arena);
+    lv_image_dsc_t* storeImageDescriptor(const String &name, const uint8_t *data, uint32_t size);
+    void setImageData(lv_image_dsc_t *imgDesc, const uint8_t *data, uint32_t size);
+    const LVMLBundleEntry* findBundleEntry(const String &url);
     void findAndProcessAllImages(lv_obj_t *parent);
     String resolveImageUrl(const String &src);
-    String preprocessXmlForImages(String xmlContent);
+    LVMLBuffer preprocessXmlForImages(LVMLBuffer &&xmlContent);
     void downloadImagesFromXml(String xmlContent);
     String generateImageDescriptorName(const String &url);
     void cleanupImageDescriptors();
     void processImageElements(tinyxml2::XMLElement* element);
+    String loadImage(const String &fullUrl);
+
+    // Helper methods for shared styles
+    void collectStyleSets(tinyxml2::XMLElement* element, std::vector<std::pair<tinyxml2::XMLElement*, String>> &sets);
+    void shareStyles(tinyxml2::XMLElement* root, tinyxml2::XMLElement* view);
+
+    // Helper methods for data binding
+    void processBindings(tinyxml2::XMLElement* element);
+    // Creates the subject a bind_* attribute refers to and returns its name
+    String ensureSubject(const char *bindAttribute, const String &key);
+    void setSubject(const String &name, const String &value);
+    void handleDataLine(const String &line);
+    void serviceDataChannel();
+
+    // Helper methods for hot reload
+    void serviceHotReload();
+    void handleChangeEvent(const String &path);
+    bool reloadImage(const String &url);
+
+    // Helper methods for incremental screen patching
+    bool patchScreenXml(const LVMLBuffer &xmlContent);
+    bool patchElement(lv_obj_t *obj, tinyxml2::XMLElement* oldElement, tinyxml2::XMLElement* newElement);
+    lv_obj_t* createElement(lv_obj_t *parent, tinyxml2::XMLElement* element);
+    lv_obj_t* createWidget(lv_obj_t *parent, const char *name, std::vector<const char*> &attrs);
+
+    // Helper methods for progressive building
+    lv_obj_t* startBuild(tinyxml2::XMLElement* view);
+    bool buildSlice(unsigned long budgetMicros);
+    void buildPending(const PendingWidget &pending, bool later);
+    void queueChildren(lv_obj_t *item, tinyxml2::XMLElement* element, bool later);
+    void finishBuild();
+    void cancelBuild();
+    static void buildTimerCallback(lv_timer_t *timer);
+
+    // Helper methods for lazy subtrees
+    void collectLazySubtrees(tinyxml2::XMLElement* element, bool inLazy);
+    void deferChildren(tinyxml2::XMLElement* element, tinyxml2::XMLElement* named, int tab);
+    void attachLazySubtrees();
+    void releaseLazySubtrees();
+    void expandLazySubtree(size_t index);
+    void expandLazySubtrees();
+    bool restoreLazySubtrees(tinyxml2::XMLElement* view);
+    // Widget of the current screen by name, building its deferred subtree
+    lv_obj_t* findWidget(const char *name);
+    static void lazyDrawCallback(lv_event_t *e);
+    static void lazyExpandAsync(void *data);
+
+    // Helper methods for compiled screens
+    lv_obj_t* createCompiledNode(LVMLCompiledReader *reader, const std::vector<const char*> &strings, lv_obj_t *parent);
+    bool applyCompiledAttr(lv_obj_t *obj, const char *name, const LVMLCompiledAttr &attr);
+    void applyAttributes(lv_obj_t *obj, const char *widgetName, std::vector<const char*> &attrs);
 };
@@ -0,0 +1,137 @@
+#include "lvml_arena.h"
+#include "lvml_log.h"
+#include <utility>
+
+LVMLArena::LVMLArena(bool psram, size_t limit) {
+  mPsram = psram;
+  mLimit = limit;
+  mChunks = nullptr;
+  mLarge = nullptr;
+  mUsed = 0;
+  mReserved = 0;
+  mPeak = 0;
+  mChunkCount = 0;
+}
+
+LVMLArena::~LVMLArena() {
+  release();
+}
+
+// Chunk headers are padded so chunk data is aligned for any allocation
+static const size_t kChunkHeader = 16 * ((sizeof(void*) * 3 + 15) / 16);
+
+uint8_t* LVMLArena::chunkData(Chunk *chunk) {
+  return (uint8_t*)chunk + kChunkHeader;
+}
+
+void* LVMLArena::allocate(size_t size, size_t align) {
+  if (size == 0) size = 1;
+
+  // Bump within the chunk being filled
+  if (mChunks) {
+    uintptr_t base = (uintptr_t)chunkData(mChunks);
+    size_t offset = ((base + mChunks->used + align - 1) & ~(uintptr_t)(align - 1)) - base;
+    if (offset + size <= mChunks->size) {
+      mChunks->used = offset + size;
+      mUsed += size;
+      return (void*)(base + offset);
+    }
+  }
+
+  // Requests of more than a quarter chunk would waste the rest of one
+  if (size > LVML_ARENA_CHUNK_SIZE / 4) {
+    Chunk *chunk = newChunk(size);
+    if (!chunk) return nullptr;
+    chunk->next = mLarge;
+    chunk->used = size;
+    mLarge = chunk;
+    mUsed += size;
+    return chunkData(chunk);
+  }
+
+  Chunk *chunk = newChunk(LVML_ARENA_CHUNK_SIZE);
+  if (!chunk) return nullptr;
+  chunk->next = mChunks;
+  chunk->used = size;
+  mChunks = chunk;
+  mUsed += size;
+  return chunkData(chunk);
+}
+
+const char* LVMLArena::copyString(const char *str, size_t length) {
+  char *copy = (char*)allocate(length + 1, 1);
+  if (!copy) return nullptr;
+  memcpy(copy, str, length);
+  copy[length] = 0;
+  return copy;
+}
+
+bool LVMLArena::contains(const void *ptr) const {
+  const uint8_t *p = (const uint8_t*)ptr;
+  for (Chunk *list : {mChunks, mLarge}) {
+    for (Chunk *chunk = list; chunk; chunk = chunk->next) {
+      const uint8_t *data = chunkData(chunk);
+      if (p >= data && p < data + chunk->size) return true;
+    }
+  }
+  return false;
+}
+
+void LVMLArena::reset() {
+  freeChunks(mLarge);
+  mLarge = nullptr;
+  if (mChunks) {
+    freeChunks(mChunks->next);
+    mChunks->next = nullptr;
+    mChunks->used = 0;
+  }
+  mUsed = 0;
+}
+
+void LVMLArena::release() {
+  freeChunks(mLarge);
+  freeChunks(mChunks);
+  mLarge = nullptr;
+  mChunks = nullptr;
+  mUsed = 0;
+}
+
+void LVMLArena::swap(LVMLArena &other) {
+  std::swap(mPsram, other.mPsram);
+  std::swap(mLimit, other.mLimit);
+  std::swap(mChunks, other.mChunks);
+  std::swap(mLarge, other.mLarge);
+  std::swap(mUsed, other.mUsed);
+  std::swap(mReserved, other.mReserved);
+  std::swap(mPeak, other.mPeak);
+  std::swap(mChunkCount, other.mChunkCount);
+}
+
+LVMLArena::Chunk* LVMLArena::newChunk(size_t size) {
+  if (mReserved + size > mLimit) {
+    LVML_LOGW("Arena limit reached: %d + %d bytes of %d", (int)mReserved, (int)size, (int)mLimit);
+    return nullptr;
+  }
+  uint32_t caps = mPsram ? MALLOC_CAP_SPIRAM : MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  Chunk *chunk = (Chunk*)heap_caps_malloc(kChunkHeader + size, caps);
+  if (!chunk) {
+    LVML_LOGE("Failed to allocate %d byte arena chunk", (int)size);
+    return nullptr;
+  }
+  chunk->size = size;
+  chunk->used = 0;
+  mReserved += size;
+  mChunkCount++;
+  if (mReserved > mPeak) mPeak = mReserved;
+  return chunk;
+}
+
+void LVMLArena::freeChunks(Chunk *chunk) {
+  while (chunk) {
+    Chunk *next = chunk->next;
+    mReserved -= chunk->size;
+    mChunkCount--;
+    heap_caps_free(chunk);
+    chunk = next;
+  }
+}
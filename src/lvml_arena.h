@@ -0,0 +1,74 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// Arenas grow by chunks of this size; larger requests get a chunk of their own
+#ifndef LVML_ARENA_CHUNK_SIZE
+#define LVML_ARENA_CHUNK_SIZE (16 * 1024)
+#endif
+
+// Most memory one screen arena may hold; allocations beyond it fail
+#ifndef LVML_ARENA_LIMIT
+#define LVML_ARENA_LIMIT (2 * 1024 * 1024)
+#endif
+
+// 1 puts screen arenas in PSRAM, 0 in internal RAM
+#ifndef LVML_ARENA_PSRAM
+#define LVML_ARENA_PSRAM 1
+#endif
+
+// Bump allocator for memory that lives exactly as long as one screen: image
+// pixels, bundle contents, lazy subtree slices and the strings and tables
+// that describe them. Nothing is freed individually; reset() gives it all
+// back at once when the screen is left, so hours of navigation do not
+// scatter small blocks across the heap.
+class LVMLArena {
+  public:
+    explicit LVMLArena(bool psram = LVML_ARENA_PSRAM, size_t limit = LVML_ARENA_LIMIT);
+    ~LVMLArena();
+    LVMLArena(const LVMLArena &) = delete;
+    LVMLArena& operator=(const LVMLArena &) = delete;
+
+    // Returns nullptr if the arena would outgrow its limit or memory is out
+    void* allocate(size_t size, size_t align = 8);
+    const char* copyString(const char *str, size_t length);
+    const char* copyString(const char *str) { return copyString(str, strlen(str)); }
+    const char* copyString(const String &str) { return copyString(str.c_str(), str.length()); }
+
+    bool contains(const void *ptr) const;
+
+    // Frees everything handed out. One regular chunk is kept for the next
+    // screen, so steady navigation does not go back to the heap for it.
+    void reset();
+
+    // Frees all chunks, including the kept one
+    void release();
+
+    void swap(LVMLArena &other);
+
+    // Bytes handed out, bytes held in chunks and the most ever held
+    size_t used() const { return mUsed; }
+    size_t reserved() const { return mReserved; }
+    size_t peak() const { return mPeak; }
+    size_t chunks() const { return mChunkCount; }
+
+  private:
+    struct Chunk {
+      Chunk *next;
+      size_t size;   // usable bytes after the header
+      size_t used;
+    };
+
+    Chunk* newChunk(size_t size);
+    void freeChunks(Chunk *chunk);
+    static uint8_t* chunkData(Chunk *chunk);
+
+    bool mPsram;
+    size_t mLimit;
+    Chunk *mChunks;    // regular chunks, the one being filled first
+    Chunk *mLarge;     // chunks holding a single large allocation
+    size_t mUsed;
+    size_t mReserved;
+    size_t mPeak;
+    size_t mChunkCount;
+};
@@ -0,0 +1,153 @@
+#include "lvml_buffer.h"
+#include "lvml_log.h"
+
+#ifndef ARDUINO
+// lvmlc builds this file too; the host has no PSRAM
+#include <stdlib.h>
+#include <string.h>
+#define ps_realloc realloc
+#endif
+
+uint32_t LVMLBuffer::sAllocations = 0;
+uint32_t LVMLBuffer::sBytesCopied = 0;
+
+LVMLBuffer::LVMLBuffer() {
+  mData = nullptr;
+  mLength = 0;
+  mCapacity = 0;
+  mOwned = true;
+}
+
+LVMLBuffer::~LVMLBuffer() {
+  clear();
+}
+
+LVMLBuffer::LVMLBuffer(LVMLBuffer &&other) {
+  mData = other.mData;
+  mLength = other.mLength;
+  mCapacity = other.mCapacity;
+  mOwned = other.mOwned;
+  other.mData = nullptr;
+  other.mLength = 0;
+  other.mCapacity = 0;
+  other.mOwned = true;
+}
+
+LVMLBuffer& LVMLBuffer::operator=(LVMLBuffer &&other) {
+  if (this != &other) {
+    clear();
+    mData = other.mData;
+    mLength = other.mLength;
+    mCapacity = other.mCapacity;
+    mOwned = other.mOwned;
+    other.mData = nullptr;
+    other.mLength = 0;
+    other.mCapacity = 0;
+    other.mOwned = true;
+  }
+  return *this;
+}
+
+LVMLBuffer LVMLBuffer::borrow(const char *data, size_t length) {
+  LVMLBuffer buffer;
+  buffer.mData = const_cast<char*>(data);
+  buffer.mLength = length;
+  buffer.mCapacity = length;
+  buffer.mOwned = false;
+  return buffer;
+}
+
+LVMLBuffer LVMLBuffer::copyOf(const char *data, size_t length) {
+  LVMLBuffer buffer;
+  buffer.append(data, length);
+  return buffer;
+}
+
+bool LVMLBuffer::reserve(size_t capacity) {
+  if (capacity <= mCapacity && mOwned) return true;
+  if (!mOwned) return makeOwned() && reserve(capacity);
+
+  // One extra byte keeps the contents NUL-terminated
+  char *data = (char*)ps_realloc(mData, capacity + 1);
+  if (!data) {
+    LVML_LOGE("Failed to allocate %d byte buffer", (int)capacity);
+    return false;
+  }
+  sAllocations++;
+  if (data != mData && mLength > 0) {
+    sBytesCopied += mLength;
+  }
+  mData = data;
+  mCapacity = capacity;
+  mData[mLength] = 0;
+  return true;
+}
+
+bool LVMLBuffer::append(const char *data, size_t length) {
+  if (mLength + length > mCapacity || !mOwned) {
+    // Grow geometrically so streamed bodies reallocate O(log n) times
+    size_t capacity = mCapacity * 2;
+    if (capacity < mLength + length) capacity = mLength + length;
+    if (capacity < 256) capacity = 256;
+    if (!reserve(capacity)) return false;
+  }
+  memcpy(mData + mLength, data, length);
+  mLength += length;
+  mData[mLength] = 0;
+  return true;
+}
+
+void LVMLBuffer::clear() {
+  if (mOwned) {
+    free(mData);
+  }
+  mData = nullptr;
+  mLength = 0;
+  mCapacity = 0;
+  mOwned = true;
+}
+
+void LVMLBuffer::rewind() {
+  if (!mOwned) {
+    clear();
+    return;
+  }
+  mLength = 0;
+  if (mData) {
+    mData[0] = 0;
+  }
+}
+
+char* LVMLBuffer::release() {
+  if (!mOwned) return nullptr;
+  char *data = mData;
+  mData = nullptr;
+  mLength = 0;
+  mCapacity = 0;
+  return data;
+}
+
+bool LVMLBuffer::makeOwned() {
+  if (mOwned) return true;
+  const char *borrowed = mData;
+  size_t length = mLength;
+  mData = nullptr;
+  mLength = 0;
+  mCapacity = 0;
+  mOwned = true;
+  if (!reserve(length)) return false;
+  memcpy(mData, borrowed, length);
+  mLength = length;
+  mData[mLength] = 0;
+  sBytesCopied += length;
+  return true;
+}
+
+bool LVMLBuffer::equals(const LVMLBuffer &other) const {
+  return mLength == other.mLength && (mLength == 0 || memcmp(mData, other.mData, mLength) == 0);
+}
+
+void LVMLBuffer::resetStats() {
+  sAllocations = 0;
+  sBytesCopied = 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+#include <tinyxml2.h>
+
+// Owned, NUL-terminated byte buffer in PSRAM that carries a screen through
+// fetch -> rewrite -> register. It is move-only, so handing it down the
+// pipeline never copies the document.
+class LVMLBuffer {
+  public:
+    LVMLBuffer();
+    ~LVMLBuffer();
+    LVMLBuffer(LVMLBuffer &&other);
+    LVMLBuffer& operator=(LVMLBuffer &&other);
+    LVMLBuffer(const LVMLBuffer &) = delete;
+    LVMLBuffer& operator=(const LVMLBuffer &) = delete;
+
+    // Refers to memory owned by someone else (e.g. a bundle) without copying
+    static LVMLBuffer borrow(const char *data, size_t length);
+    static LVMLBuffer copyOf(const char *data, size_t length);
+
+    bool reserve(size_t capacity);
+    bool append(const char *data, size_t length);
+    bool append(char ch) { return append(&ch, 1); }
+    void clear();
+
+    // Empties the buffer but keeps an owned allocation for the next use
+    void rewind();
+
+    // Copies borrowed contents so the buffer outlives their owner
+    bool makeOwned();
+
+    // Hands an owned allocation (PSRAM, release with free()) to the caller
+    // and leaves the buffer empty; null if the contents are borrowed
+    char* release();
+
+    const char* c_str() const { return mData ? mData : ""; }
+    char* data() { return mData; }
+    size_t length() const { return mLength; }
+    bool isBorrowed() const { return mData && !mOwned; }
+    bool equals(const LVMLBuffer &other) const;
+
+    // Allocations and bytes copied by all buffers since the last reset, for
+    // measuring the cost of a screen load
+    static void resetStats();
+    static void noteCopy(size_t bytes) { sBytesCopied += bytes; }
+    static uint32_t allocations() { return sAllocations; }
+    static uint32_t bytesCopied() { return sBytesCopied; }
+
+  private:
+    char *mData;
+    size_t mLength;
+    size_t mCapacity;
+    bool mOwned;
+
+    static uint32_t sAllocations;
+    static uint32_t sBytesCopied;
+};
+
+#ifdef ARDUINO
+// Stream sink for HTTPClient::writeToStream() that appends to a buffer
+class LVMLBufferStream : public Stream {
+  public:
+    explicit LVMLBufferStream(LVMLBuffer &buffer) : mBuffer(buffer) {}
+
+    size_t write(uint8_t byte) override { return mBuffer.append((char)byte) ? 1 : 0; }
+    size_t write(const uint8_t *buffer, size_t size) override {
+      return mBuffer.append((const char*)buffer, size) ? size : 0;
+    }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+  private:
+    LVMLBuffer &mBuffer;
+};
+#endif
+
+// XMLPrinter that prints straight into a buffer instead of its own DynArray
+class LVMLBufferPrinter : public tinyxml2::XMLPrinter {
+  public:
+    explicit LVMLBufferPrinter(LVMLBuffer &buffer, bool compact = false)
+      : tinyxml2::XMLPrinter(nullptr, compact), mBuffer(buffer) {}
+
+  protected:
+    void Write(const char* data, size_t size) override {
+      mBuffer.append(data, size);
+      LVMLBuffer::noteCopy(size);
+    }
+    void Putc(char ch) override {
+      mBuffer.append(ch);
+      LVMLBuffer::noteCopy(1);
+    }
+
+  private:
+    LVMLBuffer &mBuffer;
+};
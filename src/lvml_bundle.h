@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// LVML bundle: one screen XML plus the images it references, fetched with a
+// single request.
+//
+// Layout (little endian):
+//   header   : "LVMB", uint16 version, uint16 entry count
+//   index    : per entry uint32 offset, uint32 size, uint16 path length,
+//              path bytes followed by a NUL
+//   payloads : each starts on a 4-byte boundary and is followed by a NUL,
+//              so the XML entry can be used as a C string in place
+//
+// Entry 0 is the screen XML. Paths are absolute from the server root
+// ("/assets/splash.png"), matching how LVML resolves image sources.
+
+#define LVML_BUNDLE_MAGIC "LVMB"
+#define LVML_BUNDLE_VERSION 1
+#define LVML_BUNDLE_ALIGN 4
+#define LVML_BUNDLE_EXTENSION ".lvmlb"
+#define LVML_BUNDLE_MAX_ENTRIES 64
+
+struct LVMLBundleEntry {
+  const char *path;
+  const uint8_t *data;
+  uint32_t size;
+};
+
+static inline uint16_t lvmlReadU16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t lvmlReadU32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Fills up to maxEntries entries pointing into the bundle. Returns the
+// number of entries, or 0 if the bundle is malformed.
+static inline size_t lvmlBundleParse(const uint8_t *data, size_t size,
+                                     LVMLBundleEntry *entries, size_t maxEntries) {
+  if (size < 8 || memcmp(data, LVML_BUNDLE_MAGIC, 4) != 0) return 0;
+  if (lvmlReadU16(data + 4) != LVML_BUNDLE_VERSION) return 0;
+
+  size_t count = lvmlReadU16(data + 6);
+  if (count == 0 || count > maxEntries) return 0;
+
+  // Bounds are checked as remaining sizes, which cannot wrap on 32-bit size_t
+  size_t pos = 8;
+  for (size_t i = 0; i < count; i++) {
+    if (size - pos < 10) return 0;
+    uint32_t offset = lvmlReadU32(data + pos);
+    uint32_t length = lvmlReadU32(data + pos + 4);
+    uint16_t pathLen = lvmlReadU16(data + pos + 8);
+    pos += 10;
+    if (pathLen >= size - pos || data[pos + pathLen] != 0) return 0;
+    if (offset > size || length >= size - offset || data[offset + length] != 0) return 0;
+
+    entries[i].path = (const char *)(data + pos);
+    entries[i].data = data + offset;
+    entries[i].size = length;
+    pos += pathLen + 1;
+  }
+  return count;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "lvml_bundle.h"
+
+// Compiled LVML screen: the view of a screen XML, pre-parsed by the host tool
+// (tools/lvmlc.cpp) so the device can create widgets without parsing text.
+//
+// Layout (little endian):
+//   header  : "LVMC", uint16 version, uint16 string count
+//   strings : per string uint16 length, bytes followed by a NUL; tag names,
+//             attribute names and text values are interned here
+//   nodes   : the view in preorder; per node uint16 tag, uint16 attribute
+//             count, uint16 child count, then per attribute uint16 name,
+//             uint8 type and a 4-byte value
+//
+// Constants are substituted and image sources resolved to absolute paths at
+// compile time. Numeric and color values are only typed when printing them
+// back gives the original text, so any attribute can fall back to LVGL's
+// own XML attribute parser.
+
+#define LVML_COMPILED_MAGIC "LVMC"
+#define LVML_COMPILED_VERSION 1
+#define LVML_COMPILED_EXTENSION ".lvmlc"
+
+enum LVMLValueType {
+  LVMLC_STRING = 0,   // value: string index
+  LVMLC_INT,          // value: int32
+  LVMLC_PERCENT,      // value: int32 percentage ("100%")
+  LVMLC_CONTENT,      // "content" size, value unused
+  LVMLC_COLOR,        // value: 0xRRGGBB ("0x007AFF")
+  LVMLC_IMAGE,        // value: string index of the absolute image path
+};
+
+struct LVMLCompiledAttr {
+  uint16_t name;
+  uint8_t type;
+  uint32_t value;
+};
+
+// Sequential reader over a compiled screen; error is sticky
+struct LVMLCompiledReader {
+  const uint8_t *data;
+  size_t size;
+  size_t pos;
+  bool error;
+};
+
+static inline const uint8_t *lvmlCompiledTake(LVMLCompiledReader *r, size_t n) {
+  if (r->error || r->pos + n > r->size) {
+    r->error = true;
+    return nullptr;
+  }
+  const uint8_t *p = r->data + r->pos;
+  r->pos += n;
+  return p;
+}
+
+// Checks the header and returns the number of strings that follow
+static inline bool lvmlCompiledOpen(LVMLCompiledReader *r, const uint8_t *data, size_t size,
+                                    uint16_t *stringCount) {
+  r->data = data;
+  r->size = size;
+  r->pos = 0;
+  r->error = false;
+  const uint8_t *p = lvmlCompiledTake(r, 8);
+  if (!p || memcmp(p, LVML_COMPILED_MAGIC, 4) != 0 || lvmlReadU16(p + 4) != LVML_COMPILED_VERSION) {
+    r->error = true;
+    return false;
+  }
+  *stringCount = lvmlReadU16(p + 6);
+  return true;
+}
+
+// Fills the string table with pointers into the buffer
+static inline bool lvmlCompiledStrings(LVMLCompiledReader *r, const char **strings, uint16_t count) {
+  for (uint16_t i = 0; i < count; i++) {
+    const uint8_t *p = lvmlCompiledTake(r, 2);
+    if (!p) return false;
+    uint16_t len = lvmlReadU16(p);
+    p = lvmlCompiledTake(r, (size_t)len + 1);
+    if (!p || p[len] != 0) {
+      r->error = true;
+      return false;
+    }
+    strings[i] = (const char *)p;
+  }
+  return true;
+}
+
+static inline bool lvmlCompiledNode(LVMLCompiledReader *r, uint16_t *tag, uint16_t *attrCount,
+                                    uint16_t *childCount) {
+  const uint8_t *p = lvmlCompiledTake(r, 6);
+  if (!p) return false;
+  *tag = lvmlReadU16(p);
+  *attrCount = lvmlReadU16(p + 2);
+  *childCount = lvmlReadU16(p + 4);
+  return true;
+}
+
+static inline bool lvmlCompiledAttr(LVMLCompiledReader *r, LVMLCompiledAttr *attr) {
+  const uint8_t *p = lvmlCompiledTake(r, 7);
+  if (!p) return false;
+  attr->name = lvmlReadU16(p);
+  attr->type = p[2];
+  attr->value = lvmlReadU32(p + 3);
+  return true;
+}
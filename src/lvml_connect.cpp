@@ -0,0 +1,71 @@
+#include "lvml_connect.h"
+#include <lwip/sockets.h>
+
+LVMLAsyncConnect::LVMLAsyncConnect() {
+  mFd = -1;
+  mStarted = 0;
+}
+
+LVMLAsyncConnect::~LVMLAsyncConnect() {
+  cancel();
+}
+
+bool LVMLAsyncConnect::start(const String &host, uint16_t port) {
+  cancel();
+
+  IPAddress ip;
+  if (!ip.fromString(host.c_str()) && !WiFi.hostByName(host.c_str(), ip)) return false;
+
+  int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (fd < 0) return false;
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+  struct sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = (uint32_t)ip;
+  address.sin_port = htons(port);
+  if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS) {
+    close(fd);
+    return false;
+  }
+
+  mFd = fd;
+  mStarted = millis();
+  return true;
+}
+
+int LVMLAsyncConnect::poll(WiFiClient &client) {
+  if (mFd < 0) return -1;
+
+  // Writable once the handshake finished, successfully or not
+  fd_set writable;
+  FD_ZERO(&writable);
+  FD_SET(mFd, &writable);
+  struct timeval noWait = {0, 0};
+  if (select(mFd + 1, nullptr, &writable, nullptr, &noWait) <= 0) {
+    if (millis() - mStarted < LVML_CONNECT_TIMEOUT_MS) return 0;
+    cancel();
+    return -1;
+  }
+
+  int error = 0;
+  socklen_t length = sizeof(error);
+  if (getsockopt(mFd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+    cancel();
+    return -1;
+  }
+
+  // WiFiClient does its own waiting, so hand it a blocking socket
+  fcntl(mFd, F_SETFL, fcntl(mFd, F_GETFL, 0) & ~O_NONBLOCK);
+  client = WiFiClient(mFd);
+  mFd = -1;
+  return 1;
+}
+
+void LVMLAsyncConnect::cancel() {
+  if (mFd >= 0) {
+    close(mFd);
+    mFd = -1;
+  }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+
+// How long a connection attempt may stay in progress before it is dropped
+#ifndef LVML_CONNECT_TIMEOUT_MS
+#define LVML_CONNECT_TIMEOUT_MS 3000
+#endif
+
+// TCP connect that does not block the loop it is serviced from. start()
+// opens a non-blocking socket and returns at once; poll() checks it without
+// waiting and hands the connected socket to a WiFiClient. With no server
+// listening, an attempt costs a few microseconds per loop instead of a
+// connect timeout with LVGL's timer handler stalled behind it.
+//
+// Host names are resolved with WiFi.hostByName(), which does block; use an
+// IP address for servers that may be absent.
+class LVMLAsyncConnect {
+  public:
+    LVMLAsyncConnect();
+    ~LVMLAsyncConnect();
+    LVMLAsyncConnect(const LVMLAsyncConnect &) = delete;
+    LVMLAsyncConnect& operator=(const LVMLAsyncConnect &) = delete;
+
+    // Starts an attempt; false if the host cannot be resolved or no socket
+    // is available
+    bool start(const String &host, uint16_t port);
+
+    // 1 once connected (client then owns the socket), 0 while the attempt
+    // is in progress, -1 if it failed or timed out
+    int poll(WiFiClient &client);
+
+    bool pending() const { return mFd >= 0; }
+    void cancel();
+
+  private:
+    int mFd;
+    unsigned long mStarted;
+};
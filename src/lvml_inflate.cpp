@@ -0,0 +1,182 @@
+#include "lvml_inflate.h"
+#include "lvml_log.h"
+
+// gzip header flags (RFC 1952)
+#define GZIP_FHCRC    0x02
+#define GZIP_FEXTRA   0x04
+#define GZIP_FNAME    0x08
+#define GZIP_FCOMMENT 0x10
+
+// gzip header fields, in the order they appear
+enum {
+  GZIP_PHASE_FIXED = 0,
+  GZIP_PHASE_EXTRA_LEN,
+  GZIP_PHASE_EXTRA,
+  GZIP_PHASE_NAME,
+  GZIP_PHASE_COMMENT,
+  GZIP_PHASE_HCRC,
+};
+
+LVMLInflateStream::LVMLInflateStream(bool gzip, size_t maxSize) {
+  mGzip = gzip;
+  mMaxSize = maxSize;
+  mHeaderDone = !gzip;
+  mFirstByte = true;
+  mFlags = TINFL_FLAG_HAS_MORE_INPUT;
+  mFailed = false;
+  mDone = false;
+  mBytesIn = 0;
+  mInflateMicros = 0;
+  mDictPos = 0;
+  mPhase = GZIP_PHASE_FIXED;
+  mHeaderLen = 0;
+  mGzipFlags = 0;
+  mSkip = 0;
+
+  // The inflater state (~11 KB) and the 32 KB window live in PSRAM
+  mInflator = (tinfl_decompressor*)ps_malloc(sizeof(tinfl_decompressor));
+  mDict = (uint8_t*)ps_malloc(TINFL_LZ_DICT_SIZE);
+  if (!mInflator || !mDict) {
+    LVML_LOGE("Failed to allocate inflater");
+    mFailed = true;
+    return;
+  }
+  tinfl_init(mInflator);
+}
+
+LVMLInflateStream::~LVMLInflateStream() {
+  free(mInflator);
+  free(mDict);
+}
+
+size_t LVMLInflateStream::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t LVMLInflateStream::write(const uint8_t *buffer, size_t size) {
+  mBytesIn += size;
+  if (mFailed || mDone) {
+    // Nothing left to do; the gzip trailer (CRC32, ISIZE) ends up here
+    return size;
+  }
+
+  size_t pos = 0;
+  if (!mHeaderDone) {
+    pos = skipGzipHeader(buffer, size);
+  }
+
+  if (mHeaderDone && pos < size) {
+    if (mFirstByte && !mGzip) {
+      // "deflate" should be zlib-wrapped, but some servers send raw deflate
+      uint8_t cmf = buffer[pos];
+      if ((cmf & 0x0F) == 8 && (cmf >> 4) <= 7) {
+        mFlags |= TINFL_FLAG_PARSE_ZLIB_HEADER;
+      }
+    }
+    mFirstByte = false;
+    inflate(buffer + pos, size - pos);
+  }
+  return size;
+}
+
+size_t LVMLInflateStream::skipGzipHeader(const uint8_t *buffer, size_t size) {
+  size_t pos = 0;
+  while (pos < size && !mHeaderDone && !mFailed) {
+    uint8_t b = buffer[pos++];
+    switch (mPhase) {
+      case GZIP_PHASE_FIXED:
+        mHeader[mHeaderLen++] = b;
+        if (mHeaderLen == 10) {
+          if (mHeader[0] != 0x1F || mHeader[1] != 0x8B || mHeader[2] != 8) {
+            LVML_LOGW("Invalid gzip header");
+            mFailed = true;
+            break;
+          }
+          mGzipFlags = mHeader[3];
+          nextGzipField();
+        }
+        break;
+      case GZIP_PHASE_EXTRA_LEN:
+        mHeader[mHeaderLen++] = b;
+        if (mHeaderLen == 2) {
+          mSkip = mHeader[0] | (mHeader[1] << 8);
+          nextGzipField();
+        }
+        break;
+      case GZIP_PHASE_EXTRA:
+      case GZIP_PHASE_HCRC:
+        if (--mSkip == 0) nextGzipField();
+        break;
+      case GZIP_PHASE_NAME:
+      case GZIP_PHASE_COMMENT:
+        if (b == 0) nextGzipField();
+        break;
+    }
+  }
+  return pos;
+}
+
+void LVMLInflateStream::nextGzipField() {
+  // Advance to the next field present in this header
+  for (;;) {
+    mPhase++;
+    mHeaderLen = 0;
+    if (mPhase == GZIP_PHASE_EXTRA_LEN && (mGzipFlags & GZIP_FEXTRA)) return;
+    if (mPhase == GZIP_PHASE_EXTRA && mSkip > 0) return;
+    if (mPhase == GZIP_PHASE_NAME && (mGzipFlags & GZIP_FNAME)) return;
+    if (mPhase == GZIP_PHASE_COMMENT && (mGzipFlags & GZIP_FCOMMENT)) return;
+    if (mPhase == GZIP_PHASE_HCRC && (mGzipFlags & GZIP_FHCRC)) {
+      mSkip = 2;
+      return;
+    }
+    if (mPhase >= GZIP_PHASE_HCRC) {
+      mHeaderDone = true;
+      return;
+    }
+  }
+}
+
+void LVMLInflateStream::inflate(const uint8_t *buffer, size_t size) {
+  unsigned long start = micros();
+  for (;;) {
+    // Inflate into the circular window and append what came out
+    size_t inSize = size;
+    size_t outSize = TINFL_LZ_DICT_SIZE - mDictPos;
+    tinfl_status status = tinfl_decompress(mInflator, buffer, &inSize, mDict, mDict + mDictPos, &outSize, mFlags);
+    buffer += inSize;
+    size -= inSize;
+
+    if (outSize > 0) {
+      if (mOutput.length() + outSize > mMaxSize) {
+        LVML_LOGW("Inflated body exceeds %d bytes", (int)mMaxSize);
+        fail();
+        break;
+      }
+      if (!mOutput.append((const char*)(mDict + mDictPos), outSize)) {
+        LVML_LOGW("Out of memory for the inflated body at %d bytes", (int)mOutput.length());
+        fail();
+        break;
+      }
+      mDictPos = (mDictPos + outSize) & (TINFL_LZ_DICT_SIZE - 1);
+    }
+
+    if (status == TINFL_STATUS_DONE) {
+      mDone = true;
+      break;
+    }
+    if (status < 0) {
+      LVML_LOGW("Inflate failed: %d", (int)status);
+      fail();
+      break;
+    }
+    if (status == TINFL_STATUS_NEEDS_MORE_INPUT && size == 0) {
+      break;
+    }
+  }
+  mInflateMicros += micros() - start;
+}
+
+void LVMLInflateStream::fail() {
+  mFailed = true;
+  mOutput.clear();
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include "sdkconfig.h"
+#include "lvml_buffer.h"
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#include "esp32s3/rom/miniz.h"
+#else
+#include "rom/miniz.h"
+#endif
+
+// Largest body the inflater produces. A few hundred compressed bytes can
+// inflate to megabytes, so a body that grows past this fails the stream
+// instead of using up PSRAM.
+#ifndef LVML_INFLATE_MAX_SIZE
+#define LVML_INFLATE_MAX_SIZE (1024 * 1024)
+#endif
+
+// Stream sink that inflates a gzip or deflate HTTP body as it arrives, using
+// the miniz inflater in ROM. Hand it to HTTPClient::writeToStream(), which
+// also takes care of chunked transfer encoding.
+class LVMLInflateStream : public Stream {
+  public:
+    explicit LVMLInflateStream(bool gzip, size_t maxSize = LVML_INFLATE_MAX_SIZE);
+    ~LVMLInflateStream();
+
+    // Decompressed body; empty if the stream failed, also when it would
+    // exceed maxSize or the buffer cannot grow
+    LVMLBuffer& output() { return mOutput; }
+    bool failed() const { return mFailed; }
+    bool done() const { return mDone; }
+
+    // Statistics for the last body: compressed bytes in, bytes out and time
+    // spent inside the inflater
+    size_t bytesIn() const { return mBytesIn; }
+    size_t bytesOut() const { return mOutput.length(); }
+    unsigned long inflateMicros() const { return mInflateMicros; }
+
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+  private:
+    size_t skipGzipHeader(const uint8_t *buffer, size_t size);
+    void nextGzipField();
+    void inflate(const uint8_t *buffer, size_t size);
+    void fail();
+
+    LVMLBuffer mOutput;
+    tinfl_decompressor *mInflator;
+    uint8_t *mDict;
+    size_t mDictPos;
+    bool mGzip;
+    bool mHeaderDone;
+    bool mFirstByte;
+    uint32_t mFlags;
+    size_t mMaxSize;
+    bool mFailed;
+    bool mDone;
+    size_t mBytesIn;
+    unsigned long mInflateMicros;
+
+    // gzip header parser state
+    int mPhase;
+    uint8_t mHeader[10];
+    size_t mHeaderLen;
+    uint8_t mGzipFlags;
+    size_t mSkip;
+};
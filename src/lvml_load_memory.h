@@ -0,0 +1,127 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Memory accounting for screen loads. The samples come from heap_caps and
+// LVGL's pool on the device and from an allocator hook on the host.
+
+// Points of a screen load at which memory use is sampled
+enum LVMLLoadPhase {
+  LVML_PHASE_FETCH,       // before the screen is fetched (the baseline)
+  LVML_PHASE_PREPROCESS,  // XML parsed and rewritten, images loaded
+  LVML_PHASE_CREATE,      // widgets created
+  LVML_PHASE_RELEASE,     // previous screen and its memory released
+  LVML_PHASE_COUNT
+};
+
+// Bytes in use per memory region
+struct LVMLMemoryUse {
+  int32_t internal;
+  int32_t psram;
+  int32_t lvgl;     // LVGL's heap
+};
+
+// Cost of one load: use at each phase relative to the baseline, and the
+// highest use above the baseline seen during the load
+struct LVMLLoadMemory {
+  LVMLMemoryUse phase[LVML_PHASE_COUNT];
+  LVMLMemoryUse peak;
+  uint8_t sampled;  // bit per phase recorded
+};
+
+// Loads of one screen: the last one and the highest peaks of all of them
+struct LVMLScreenMemory {
+  LVMLLoadMemory last;
+  LVMLMemoryUse peak;
+  uint32_t loads;
+};
+
+// Samples one load. `highWater` is the platform's running maximum of bytes
+// in use, or the current use where there is none; a rise during the load is
+// a peak between samples that the samples alone would miss.
+class LVMLLoadTracker {
+  public:
+    LVMLLoadTracker() : mActive(false) {}
+
+    void begin(const LVMLMemoryUse &now, const LVMLMemoryUse &highWater) {
+      mActive = true;
+      mBase = now;
+      mHighWater = highWater;
+      mLoad = LVMLLoadMemory();
+      sample(LVML_PHASE_FETCH, now, highWater);
+    }
+
+    void sample(LVMLLoadPhase phase, const LVMLMemoryUse &now, const LVMLMemoryUse &highWater) {
+      if (!mActive) return;
+      mLoad.phase[phase] = delta(now);
+      mLoad.sampled |= 1 << phase;
+      raisePeak(mLoad.peak.internal, now.internal - mBase.internal,
+                highWater.internal > mHighWater.internal ? highWater.internal - mBase.internal : 0);
+      raisePeak(mLoad.peak.psram, now.psram - mBase.psram,
+                highWater.psram > mHighWater.psram ? highWater.psram - mBase.psram : 0);
+      raisePeak(mLoad.peak.lvgl, now.lvgl - mBase.lvgl,
+                highWater.lvgl > mHighWater.lvgl ? highWater.lvgl - mBase.lvgl : 0);
+    }
+
+    // Ends the load; returns false if it was not started
+    bool end(LVMLLoadMemory &result) {
+      if (!mActive) return false;
+      mActive = false;
+      result = mLoad;
+      return true;
+    }
+
+    bool active() const { return mActive; }
+
+    // Adds a finished load to the totals of its screen
+    static void record(LVMLScreenMemory &screen, const LVMLLoadMemory &load) {
+      screen.last = load;
+      raisePeak(screen.peak.internal, load.peak.internal, 0);
+      raisePeak(screen.peak.psram, load.peak.psram, 0);
+      raisePeak(screen.peak.lvgl, load.peak.lvgl, 0);
+      screen.loads++;
+    }
+
+    // One line per load: per region the use after preprocess, create and
+    // release relative to before the fetch ("-" if not sampled), then the
+    // peak, e.g. "internal +812 +9120 +64 ^10240 psram ..."
+    static int format(const LVMLLoadMemory &load, char *out, size_t size) {
+      static const char *const kRegions[] = {"internal", "psram", "lvgl"};
+      int length = 0;
+      for (int region = 0; region < 3; region++) {
+        length += snprintf(out + length, size > (size_t)length ? size - length : 0, "%s%s",
+                           region ? " " : "", kRegions[region]);
+        for (int phase = LVML_PHASE_PREPROCESS; phase < LVML_PHASE_COUNT; phase++) {
+          if (load.sampled & (1 << phase)) {
+            length += snprintf(out + length, size > (size_t)length ? size - length : 0, " %+ld",
+                               (long)field(load.phase[phase], region));
+          } else {
+            length += snprintf(out + length, size > (size_t)length ? size - length : 0, " -");
+          }
+        }
+        length += snprintf(out + length, size > (size_t)length ? size - length : 0, " ^%ld",
+                           (long)field(load.peak, region));
+      }
+      return length;
+    }
+
+  private:
+    LVMLMemoryUse delta(const LVMLMemoryUse &now) const {
+      return {now.internal - mBase.internal, now.psram - mBase.psram, now.lvgl - mBase.lvgl};
+    }
+
+    static void raisePeak(int32_t &peak, int32_t value, int32_t highWater) {
+      if (value > peak) peak = value;
+      if (highWater > peak) peak = highWater;
+    }
+
+    static int32_t field(const LVMLMemoryUse &use, int region) {
+      return region == 0 ? use.internal : region == 1 ? use.psram : use.lvgl;
+    }
+
+    bool mActive;
+    LVMLMemoryUse mBase;
+    LVMLMemoryUse mHighWater;
+    LVMLLoadMemory mLoad;
+};
@@ -0,0 +1,73 @@
+#include "lvml_log.h"
+#include <lvgl.h>
+
+// Core the writer task runs on; Arduino's loop task runs on core 1
+#ifndef LVML_LOG_CORE
+#define LVML_LOG_CORE 0
+#endif
+
+// How often the writer task looks for new records
+#ifndef LVML_LOG_INTERVAL_MS
+#define LVML_LOG_INTERVAL_MS 20
+#endif
+
+static Print *sLogOutput = nullptr;
+static SemaphoreHandle_t sLogOutputLock = nullptr;
+
+size_t lvmlLogDrain(Print &out, size_t maxLines) {
+  char line[LVML_LOG_MAX_LINE];
+  size_t lines = 0;
+  while (lines < maxLines) {
+    size_t length = LVMLLog::instance().read(line, sizeof(line));
+    if (length == 0) break;
+    out.write((const uint8_t *)line, length);
+    lines++;
+  }
+  return lines;
+}
+
+static void logTask(void *) {
+  for (;;) {
+    xSemaphoreTake(sLogOutputLock, portMAX_DELAY);
+    lvmlLogDrain(*sLogOutput);
+    xSemaphoreGive(sLogOutputLock);
+    vTaskDelay(pdMS_TO_TICKS(LVML_LOG_INTERVAL_MS));
+  }
+}
+
+void lvmlLogBegin(Print &out) {
+  if (sLogOutput) return;
+  sLogOutput = &out;
+  sLogOutputLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(logTask, "lvml_log", 4096, nullptr, 1, nullptr, LVML_LOG_CORE);
+}
+
+void lvmlLogPauseOutput() {
+  if (sLogOutputLock) xSemaphoreTake(sLogOutputLock, portMAX_DELAY);
+}
+
+void lvmlLogResumeOutput() {
+  if (sLogOutputLock) xSemaphoreGive(sLogOutputLock);
+}
+
+void lvmlLogFlush() {
+  if (!sLogOutput) return;
+  lvmlLogPauseOutput();
+  lvmlLogDrain(*sLogOutput);
+  sLogOutput->flush();
+  lvmlLogResumeOutput();
+}
+
+void lvmlLogLvgl(int8_t level, const char *message) {
+  // LVGL ends its messages with a newline, which the record adds back
+  int logLevel = level == LV_LOG_LEVEL_ERROR ? LVML_LOG_ERROR :
+                 level == LV_LOG_LEVEL_WARN ? LVML_LOG_WARN :
+                 level == LV_LOG_LEVEL_USER ? LVML_LOG_INFO : LVML_LOG_DEBUG;
+  size_t length = strlen(message);
+  while (length > 0 && (message[length - 1] == '\n' || message[length - 1] == '\r')) length--;
+  char text[LVML_LOG_MAX_STRING + 1];
+  if (length > LVML_LOG_MAX_STRING) length = LVML_LOG_MAX_STRING;
+  memcpy(text, message, length);
+  text[length] = '\0';
+  LVML_LOG(logLevel, "LVGL: %s", text);
+}
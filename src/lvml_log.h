@@ -0,0 +1,439 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <mutex>
+#endif
+
+// Deferred logging. LVML_LOGI("Bundle loaded: %s", url) does not format
+// anything: it copies the format string's address (its ID, the literal
+// stays in flash) and the raw arguments into a ring buffer, strings
+// included. Formatting and the slow write to the serial port happen later,
+// on the other core (lvmlLogBegin()) or wherever lvmlLogDrain() is called.
+
+enum LVMLLogLevel {
+  LVML_LOG_NONE,
+  LVML_LOG_ERROR,
+  LVML_LOG_WARN,
+  LVML_LOG_INFO,
+  LVML_LOG_DEBUG,
+};
+
+// Level at startup; lvmlLogSetLevel() changes it at runtime
+#ifndef LVML_LOG_LEVEL
+#define LVML_LOG_LEVEL LVML_LOG_INFO
+#endif
+
+// Bytes of log records kept until they are written; when it is full new
+// records are dropped and counted
+#ifndef LVML_LOG_BUFFER_SIZE
+#define LVML_LOG_BUFFER_SIZE (8 * 1024)
+#endif
+
+// Longest string argument kept; longer ones are cut. Records store the
+// length in one byte.
+#ifndef LVML_LOG_MAX_STRING
+#define LVML_LOG_MAX_STRING 160
+#endif
+static_assert(LVML_LOG_MAX_STRING <= 255, "LVML_LOG_MAX_STRING must fit the one-byte length of a record");
+
+// Longest record (arguments) and formatted line
+#ifndef LVML_LOG_MAX_RECORD
+#define LVML_LOG_MAX_RECORD 384
+#endif
+
+#ifndef LVML_LOG_MAX_LINE
+#define LVML_LOG_MAX_LINE 320
+#endif
+
+namespace lvmllog {
+
+enum ArgType : uint8_t { ARG_INT32, ARG_INT64, ARG_DOUBLE, ARG_STRING, ARG_POINTER };
+
+// Appends type-tagged arguments to a record; stops when it is full
+class Encoder {
+  public:
+    Encoder(uint8_t *data, size_t size) : mData(data), mSize(size), mLength(0), mCount(0) {}
+
+    void put(ArgType type, const void *value, size_t size) {
+      if (mLength + 1 + size > mSize) {
+        mLength = mSize;
+        return;
+      }
+      mData[mLength++] = type;
+      memcpy(mData + mLength, value, size);
+      mLength += size;
+      mCount++;
+    }
+
+    void putString(const char *str) {
+      if (!str) str = "(null)";
+      size_t length = strnlen(str, LVML_LOG_MAX_STRING);
+      if (mLength + 2 + length > mSize) {
+        mLength = mSize;
+        return;
+      }
+      mData[mLength++] = ARG_STRING;
+      mData[mLength++] = (uint8_t)length;
+      memcpy(mData + mLength, str, length);
+      mLength += length;
+      mCount++;
+    }
+
+    size_t length() const { return mLength; }
+    uint8_t count() const { return mCount; }
+
+  private:
+    uint8_t *mData;
+    size_t mSize;
+    size_t mLength;
+    uint8_t mCount;
+};
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+encode(Encoder &encoder, T value) {
+  if (sizeof(T) <= 4) {
+    int32_t word = (int32_t)value;
+    encoder.put(ARG_INT32, &word, sizeof(word));
+  } else {
+    int64_t word = (int64_t)value;
+    encoder.put(ARG_INT64, &word, sizeof(word));
+  }
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type encode(Encoder &encoder, T value) {
+  double word = value;
+  encoder.put(ARG_DOUBLE, &word, sizeof(word));
+}
+
+inline void encode(Encoder &encoder, const char *value) { encoder.putString(value); }
+inline void encode(Encoder &encoder, char *value) { encoder.putString(value); }
+
+template <typename T>
+void encode(Encoder &encoder, T *value) {
+  const void *pointer = value;
+  encoder.put(ARG_POINTER, &pointer, sizeof(pointer));
+}
+
+inline void encodeAll(Encoder &) {}
+
+template <typename T, typename... Args>
+void encodeAll(Encoder &encoder, T value, Args... args) {
+  encode(encoder, value);
+  encodeAll(encoder, args...);
+}
+
+// Checks the arguments against the format at compile time, like printf
+inline void __attribute__((format(printf, 1, 2))) checkFormat(const char *, ...) {}
+
+}  // namespace lvmllog
+
+struct LVMLLogStats {
+  uint32_t calls;     // log calls above the level
+  uint32_t dropped;   // records lost to a full buffer
+  uint32_t pending;   // bytes waiting to be written
+  uint32_t highWater; // most bytes ever waiting
+  uint32_t meanNs;    // mean time spent in a log call
+};
+
+class LVMLLog {
+  public:
+    static LVMLLog& instance() {
+      static LVMLLog log;
+      return log;
+    }
+
+    int level() const { return mLevel; }
+    void setLevel(int level) { mLevel = level; }
+
+    template <typename... Args>
+    void write(uint8_t level, const char *format, Args... args) {
+      uint32_t start = ticks();
+      uint8_t record[LVML_LOG_MAX_RECORD];
+      lvmllog::Encoder encoder(record + sizeof(Header), sizeof(record) - sizeof(Header));
+      lvmllog::encodeAll(encoder, args...);
+      Header header;
+      header.length = (uint16_t)(sizeof(Header) + encoder.length());
+      header.level = level;
+      header.count = encoder.count();
+      header.time = now();
+      header.format = format;
+      memcpy(record, &header, sizeof(header));
+      commit(record, header.length, start);
+    }
+
+    // Takes the oldest record off the buffer and formats it into line,
+    // including the newline; returns the length, 0 if there is none
+    size_t read(char *line, size_t size) {
+      uint8_t record[LVML_LOG_MAX_RECORD];
+      bool found = false;
+      lock();
+      uint32_t dropped = mDropped - mDroppedReported;
+      if (dropped > 0) {
+        mDroppedReported = mDropped;
+        unlock();
+        return snprintf(line, size, "(%lu log line(s) dropped)\n", (unsigned long)dropped);
+      }
+      while (mUsed > 0) {
+        // Padding may be shorter than a header: only its length and level are there
+        uint16_t length;
+        memcpy(&length, mBuffer + mTail, sizeof(length));
+        size_t stored = align(length);
+        if (mBuffer[mTail + offsetof(Header, level)] != kPadding) {
+          memcpy(record, mBuffer + mTail, length);
+          found = true;
+        }
+        mTail = (mTail + stored) % LVML_LOG_BUFFER_SIZE;
+        mUsed -= stored;
+        if (found) break;
+      }
+      unlock();
+      return found ? format(record, line, size) : 0;
+    }
+
+    LVMLLogStats stats() {
+      LVMLLogStats stats;
+      lock();
+      stats.calls = mCalls;
+      stats.dropped = mDropped;
+      stats.pending = (uint32_t)mUsed;
+      stats.highWater = (uint32_t)mHighWater;
+      stats.meanNs = mCalls ? (uint32_t)(ticksToNs(mTicks) / mCalls) : 0;
+      unlock();
+      return stats;
+    }
+
+    // Formats a record as "[seconds.millis] message\n"
+    static size_t format(const uint8_t *record, char *line, size_t size) {
+      Header header;
+      memcpy(&header, record, sizeof(header));
+      const uint8_t *arg = record + sizeof(Header);
+      const uint8_t *end = record + header.length;
+      int length = snprintf(line, size, "[%lu.%03lu] %s", (unsigned long)(header.time / 1000),
+                            (unsigned long)(header.time % 1000),
+                            header.level == LVML_LOG_ERROR ? "error: " :
+                            header.level == LVML_LOG_WARN ? "warning: " : "");
+      const char *p = header.format;
+      while (*p && length < (int)size - 1) {
+        if (*p != '%') {
+          line[length++] = *p++;
+          continue;
+        }
+        if (p[1] == '%') {
+          line[length++] = '%';
+          p += 2;
+          continue;
+        }
+
+        // Flags, width and precision are kept, the length modifier is
+        // replaced to match the stored argument
+        char spec[24];
+        size_t specLength = 0;
+        spec[specLength++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && specLength < sizeof(spec) - 4) spec[specLength++] = *p++;
+        while (*p && strchr("hlLqjzt", *p)) p++;
+        char conversion = *p;
+        if (conversion) p++;
+        if (arg >= end) break;
+        length += formatArg(spec, specLength, conversion, arg, line + length, size - length);
+      }
+      if (length > (int)size - 2) length = (int)size - 2;
+      line[length++] = '\n';
+      line[length] = '\0';
+      return length;
+    }
+
+  private:
+    struct Header {
+      uint16_t length;   // header and arguments
+      uint8_t level;
+      uint8_t count;
+      uint32_t time;     // milliseconds
+      const char *format;
+    };
+
+    static const uint8_t kPadding = 0xff;
+
+    LVMLLog() : mLevel(LVML_LOG_LEVEL), mHead(0), mTail(0), mUsed(0), mHighWater(0),
+                mCalls(0), mDropped(0), mDroppedReported(0), mTicks(0) {
+#ifdef ARDUINO
+      mLock = portMUX_INITIALIZER_UNLOCKED;
+#endif
+    }
+
+    static size_t align(size_t length) { return (length + 7) & ~(size_t)7; }
+
+    void commit(const uint8_t *record, size_t length, uint32_t start) {
+      size_t stored = align(length);
+      lock();
+      // Records do not wrap; the rest of the buffer is skipped instead
+      size_t padding = mHead + stored > LVML_LOG_BUFFER_SIZE ? LVML_LOG_BUFFER_SIZE - mHead : 0;
+      if (mUsed + padding + stored > LVML_LOG_BUFFER_SIZE) {
+        mDropped++;
+      } else {
+        if (padding) {
+          uint16_t paddingLength = (uint16_t)padding;
+          memcpy(mBuffer + mHead, &paddingLength, sizeof(paddingLength));
+          mBuffer[mHead + offsetof(Header, level)] = kPadding;
+          mHead = 0;
+          mUsed += padding;
+        }
+        memcpy(mBuffer + mHead, record, length);
+        mHead = (mHead + stored) % LVML_LOG_BUFFER_SIZE;
+        mUsed += stored;
+        if (mUsed > mHighWater) mHighWater = mUsed;
+      }
+      mCalls++;
+      mTicks += ticks() - start;
+      unlock();
+    }
+
+    static size_t formatArg(const char *prefix, size_t prefixLength, char conversion, const uint8_t *&arg,
+                            char *out, size_t size) {
+      uint8_t type = *arg++;
+      int64_t integer = 0;
+      double real = 0;
+      const void *pointer = nullptr;
+      char text[LVML_LOG_MAX_STRING + 1];
+      switch (type) {
+        case lvmllog::ARG_INT32: {
+          int32_t word;
+          memcpy(&word, arg, sizeof(word));
+          arg += sizeof(word);
+          integer = strchr("di", conversion) ? (int64_t)word : (int64_t)(uint32_t)word;
+          real = word;
+          break;
+        }
+        case lvmllog::ARG_INT64:
+          memcpy(&integer, arg, sizeof(integer));
+          arg += sizeof(integer);
+          real = (double)integer;
+          break;
+        case lvmllog::ARG_DOUBLE:
+          memcpy(&real, arg, sizeof(real));
+          arg += sizeof(real);
+          integer = (int64_t)real;
+          break;
+        case lvmllog::ARG_POINTER:
+          memcpy(&pointer, arg, sizeof(pointer));
+          arg += sizeof(pointer);
+          integer = (int64_t)(intptr_t)pointer;
+          break;
+        case lvmllog::ARG_STRING: {
+          size_t length = *arg++;
+          memcpy(text, arg, length);
+          text[length] = '\0';
+          arg += length;
+          break;
+        }
+      }
+
+      char spec[24];
+      memcpy(spec, prefix, prefixLength);
+      size_t specLength = prefixLength;
+      int written = 0;
+      if (conversion && strchr("diouxX", conversion)) {
+        spec[specLength++] = 'l';
+        spec[specLength++] = 'l';
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+        written = snprintf(out, size, spec, (long long)integer);
+      } else if (conversion && strchr("fFeEgGaA", conversion)) {
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+        written = snprintf(out, size, spec, real);
+      } else if (conversion == 'c') {
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+        written = snprintf(out, size, spec, (int)integer);
+      } else if (conversion == 's') {
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+        written = snprintf(out, size, spec, type == lvmllog::ARG_STRING ? text : "?");
+      } else {
+        spec[specLength++] = 'p';
+        spec[specLength] = '\0';
+        written = snprintf(out, size, spec, pointer);
+      }
+      if (written < 0) return 0;
+      return (size_t)written < size ? (size_t)written : size - 1;
+    }
+
+#ifdef ARDUINO
+    void lock() { portENTER_CRITICAL(&mLock); }
+    void unlock() { portEXIT_CRITICAL(&mLock); }
+    static uint32_t now() { return millis(); }
+    static uint32_t ticks() { return ESP.getCycleCount(); }
+    static uint64_t ticksToNs(uint64_t ticks) { return ticks * 1000 / ESP.getCpuFreqMHz(); }
+    portMUX_TYPE mLock;
+#else
+    void lock() { mLock.lock(); }
+    void unlock() { mLock.unlock(); }
+    static uint32_t now() {
+      using namespace std::chrono;
+      return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+    static uint32_t ticks() {
+      using namespace std::chrono;
+      return (uint32_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+    static uint64_t ticksToNs(uint64_t ticks) { return ticks; }
+    std::mutex mLock;
+#endif
+
+    volatile int mLevel;
+    uint8_t mBuffer[LVML_LOG_BUFFER_SIZE] __attribute__((aligned(8)));
+    size_t mHead;
+    size_t mTail;
+    size_t mUsed;
+    size_t mHighWater;
+    uint32_t mCalls;
+    uint32_t mDropped;
+    uint32_t mDroppedReported;
+    uint64_t mTicks;
+};
+
+static_assert(LVML_LOG_BUFFER_SIZE % 8 == 0, "LVML_LOG_BUFFER_SIZE must be a multiple of 8");
+
+#define LVML_LOG(logLevel, ...)                               \
+  do {                                                        \
+    if ((logLevel) <= LVMLLog::instance().level()) {          \
+      if (0) lvmllog::checkFormat(__VA_ARGS__);               \
+      LVMLLog::instance().write((logLevel), __VA_ARGS__);     \
+    }                                                         \
+  } while (0)
+
+#define LVML_LOGE(...) LVML_LOG(LVML_LOG_ERROR, __VA_ARGS__)
+#define LVML_LOGW(...) LVML_LOG(LVML_LOG_WARN, __VA_ARGS__)
+#define LVML_LOGI(...) LVML_LOG(LVML_LOG_INFO, __VA_ARGS__)
+#define LVML_LOGD(...) LVML_LOG(LVML_LOG_DEBUG, __VA_ARGS__)
+
+inline void lvmlLogSetLevel(int level) { LVMLLog::instance().setLevel(level); }
+
+#ifdef ARDUINO
+// Writes records to out from a task on core LVML_LOG_CORE, away from the
+// loop task that renders and loads screens
+void lvmlLogBegin(Print &out);
+
+// Writes up to maxLines pending records to out; for use without the task
+size_t lvmlLogDrain(Print &out, size_t maxLines = SIZE_MAX);
+
+// Holds the writer task back between whole lines, so other output to the
+// same port (a trace dump) is not interleaved with log lines
+void lvmlLogPauseOutput();
+void lvmlLogResumeOutput();
+
+// Writes every pending record now, before an abort for instance
+void lvmlLogFlush();
+
+// LVGL's log print callback: LVGL's own messages go through the same buffer
+void lvmlLogLvgl(int8_t level, const char *message);
+#endif
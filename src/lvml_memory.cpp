@@ -0,0 +1,62 @@
+#include "lvml_memory.h"
+#include <lvgl.h>
+
+#include "lvml_log.h"
+
+void* lvmlXmlAllocate(size_t size, uint32_t caps) {
+  void *mem = heap_caps_malloc(size, caps);
+  if (!mem) mem = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+  if (!mem) {
+    LVML_LOGE("Out of memory: %d bytes for an XML document", (int)size);
+    lvmlLogFlush();
+    abort();
+  }
+  return mem;
+}
+
+LVMLHeapStats lvmlLvglHeapStats() {
+  LVMLHeapStats stats;
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+  lv_mem_monitor_t monitor;
+  lv_mem_monitor(&monitor);
+  stats.total = monitor.total_size;
+  stats.free = monitor.free_size;
+  stats.used = monitor.total_size - monitor.free_size;
+  stats.largestFree = monitor.free_biggest_size;
+  stats.peak = monitor.max_used;
+  stats.fragmentation = monitor.frag_pct;
+#else
+  stats.total = heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
+  stats.free = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+  stats.used = stats.total - stats.free;
+  stats.largestFree = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+  stats.peak = stats.total - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+  stats.fragmentation = stats.free ? (uint8_t)(100 - stats.largestFree * 100 / stats.free) : 0;
+#endif
+  return stats;
+}
+
+size_t lvmlPngDecodeBytes(const uint8_t *data, size_t size) {
+  // Signature, then the IHDR chunk with big-endian width and height
+  static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  if (size < 24 || memcmp(data, signature, 8) != 0 || memcmp(data + 12, "IHDR", 4) != 0) return 0;
+  uint32_t width = ((uint32_t)data[16] << 24) | (data[17] << 16) | (data[18] << 8) | data[19];
+  uint32_t height = ((uint32_t)data[20] << 24) | (data[21] << 16) | (data[22] << 8) | data[23];
+  return 2 * (size_t)width * height * 4;
+}
+
+static int32_t inUse(uint32_t caps) {
+  return (int32_t)(heap_caps_get_total_size(caps) - heap_caps_get_free_size(caps));
+}
+
+static int32_t highWater(uint32_t caps) {
+  return (int32_t)(heap_caps_get_total_size(caps) - heap_caps_get_minimum_free_size(caps));
+}
+
+LVMLMemoryUse lvmlMemoryInUse(const LVMLHeapStats &lvgl) {
+  return {inUse(MALLOC_CAP_INTERNAL), inUse(MALLOC_CAP_SPIRAM), (int32_t)lvgl.used};
+}
+
+LVMLMemoryUse lvmlMemoryHighWater(const LVMLHeapStats &lvgl) {
+  return {highWater(MALLOC_CAP_INTERNAL), highWater(MALLOC_CAP_SPIRAM), (int32_t)lvgl.peak};
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <tinyxml2.h>
+
+#include "lvml_load_memory.h"
+
+// tinyxml2 allocators for the two memory regions of the ESP32-S3. PSRAM is
+// large but slower; internal SRAM is fast but scarce and shared with WiFi.
+// tinyxml2 does not check for null, so when their region is full they take
+// the other one, and when both are they log and abort.
+
+// Allocates from the heap with caps, then from any byte-addressable heap;
+// never returns null
+void* lvmlXmlAllocate(size_t size, uint32_t caps);
+
+class LVMLPsramAllocator : public tinyxml2::XMLAllocator {
+  public:
+    void* Allocate(size_t size) override {
+      return lvmlXmlAllocate(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    void Deallocate(void *mem) override { heap_caps_free(mem); }
+};
+
+class LVMLInternalAllocator : public tinyxml2::XMLAllocator {
+  public:
+    void* Allocate(size_t size) override {
+      return lvmlXmlAllocate(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    void Deallocate(void *mem) override { heap_caps_free(mem); }
+};
+
+// PSRAM block freed with its owner. Declared before the members carved from
+// it, it is destroyed after them.
+class LVMLPsramBlock {
+  public:
+    LVMLPsramBlock() : mMemory(nullptr) {}
+    ~LVMLPsramBlock() { free(mMemory); }
+    LVMLPsramBlock(const LVMLPsramBlock &) = delete;
+    LVMLPsramBlock& operator=(const LVMLPsramBlock &) = delete;
+
+    // Allocates once; null if PSRAM is short
+    void* allocate(size_t size) {
+      if (!mMemory) mMemory = ps_malloc(size);
+      return mMemory;
+    }
+    void* memory() const { return mMemory; }
+
+  private:
+    void *mMemory;
+};
+
+// Usage of the heap LVGL allocates from. With the TLSF pool set up in
+// lv_conf.h these are the pool's own counters; with the C library's malloc
+// they describe the default heap LVGL shares with everything else.
+struct LVMLHeapStats {
+  size_t total;
+  size_t used;
+  size_t free;
+  size_t largestFree;
+  size_t peak;            // most ever in use
+  uint8_t fragmentation;  // percent of free memory outside the largest block
+};
+
+LVMLHeapStats lvmlLvglHeapStats();
+
+// LVGL heap a PNG takes while lodepng decodes it: the 32-bit pixels plus the
+// draw buffer they are converted into, both w * h * 4. 0 if data is not a PNG.
+size_t lvmlPngDecodeBytes(const uint8_t *data, size_t size);
+
+// Bytes in use in internal RAM, PSRAM and LVGL's heap, and the most ever in
+// use in each, for LVMLLoadTracker. LVGL's figures come from a snapshot of
+// lvmlLvglHeapStats(), which walks the whole pool.
+LVMLMemoryUse lvmlMemoryInUse(const LVMLHeapStats &lvgl);
+LVMLMemoryUse lvmlMemoryHighWater(const LVMLHeapStats &lvgl);
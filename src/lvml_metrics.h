@@ -0,0 +1,187 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Counters and latency histograms for the metrics endpoint. Recording is an
+// increment or a short bucket search; text is only produced when a scraper
+// asks, in the Prometheus text format.
+
+// Most buckets of a histogram, not counting +Inf
+#ifndef LVML_METRICS_MAX_BUCKETS
+#define LVML_METRICS_MAX_BUCKETS 12
+#endif
+
+// Stages of a screen load timed by the load histograms
+enum LVMLLoadStage {
+  LVML_STAGE_FETCH,       // screen body downloaded
+  LVML_STAGE_PREPROCESS,  // parsed, images loaded, rewritten
+  LVML_STAGE_CREATE,      // registered and widgets created (the first slice of a progressive build)
+  LVML_STAGE_TOTAL,       // the whole load
+  LVML_STAGE_COUNT
+};
+
+// Where the images of a screen came from
+enum LVMLImageSource {
+  LVML_IMAGE_BUNDLE,
+  LVML_IMAGE_PREFETCH,
+  LVML_IMAGE_DOWNLOAD,
+  LVML_IMAGE_FAILED,
+  LVML_IMAGE_SOURCE_COUNT
+};
+
+// Histogram of microsecond values with fixed upper bounds
+class LVMLHistogram {
+  public:
+    template <size_t N>
+    explicit LVMLHistogram(const uint32_t (&bounds)[N]) : mBounds(bounds), mCounts(), mSum(0), mCount(0) {
+      static_assert(N <= LVML_METRICS_MAX_BUCKETS, "too many histogram buckets");
+      mBucketCount = N;
+    }
+
+    void observe(uint32_t micros) {
+      size_t bucket = 0;
+      while (bucket < mBucketCount && micros > mBounds[bucket]) bucket++;
+      mCounts[bucket]++;
+      mSum += micros;
+      mCount++;
+    }
+
+    size_t buckets() const { return mBucketCount; }
+    uint32_t bound(size_t bucket) const { return mBounds[bucket]; }
+    // Observations in the bucket alone; bucket buckets() is +Inf
+    uint32_t bucketCount(size_t bucket) const { return mCounts[bucket]; }
+    uint64_t sum() const { return mSum; }
+    uint32_t count() const { return mCount; }
+
+  private:
+    const uint32_t *mBounds;
+    size_t mBucketCount;
+    uint32_t mCounts[LVML_METRICS_MAX_BUCKETS + 1];
+    uint64_t mSum;
+    uint32_t mCount;
+};
+
+struct LVMLMetrics {
+  LVMLMetrics()
+      : load{LVMLHistogram(loadBounds()), LVMLHistogram(loadBounds()), LVMLHistogram(loadBounds()),
+             LVMLHistogram(loadBounds())},
+        frame(frameBounds()),
+        flush(frameBounds()),
+        touch(touchBounds()),
+        loadsOk(0), loadsFailed(0), images(), descriptorsReused(0), descriptorsCreated(0) {}
+
+    static LVMLMetrics& instance() {
+      static LVMLMetrics metrics;
+      return metrics;
+    }
+
+    LVMLHistogram load[LVML_STAGE_COUNT];
+    LVMLHistogram frame;  // render start to the last flush of the frame
+    LVMLHistogram flush;  // one my_disp_flush call
+    LVMLHistogram touch;  // press to the end of the next frame
+    uint32_t loadsOk;
+    uint32_t loadsFailed;
+    uint32_t images[LVML_IMAGE_SOURCE_COUNT];
+    uint32_t descriptorsReused;
+    uint32_t descriptorsCreated;
+
+  private:
+    // Bucket bounds in microseconds
+    static const uint32_t (&loadBounds())[10] {
+      static const uint32_t bounds[10] = {5000, 10000, 25000, 50000, 100000, 250000, 500000,
+                                          1000000, 2500000, 5000000};
+      return bounds;
+    }
+    static const uint32_t (&frameBounds())[9] {
+      static const uint32_t bounds[9] = {1000, 2000, 5000, 10000, 16667, 33333, 50000, 100000, 250000};
+      return bounds;
+    }
+    static const uint32_t (&touchBounds())[7] {
+      static const uint32_t bounds[7] = {10000, 25000, 50000, 100000, 250000, 500000, 1000000};
+      return bounds;
+    }
+};
+
+// Writes samples in the Prometheus text format through write(const char*)
+template <typename Write>
+class LVMLMetricsWriter {
+  public:
+    explicit LVMLMetricsWriter(Write write) : mWrite(write) {}
+
+    // "# HELP" and "# TYPE" lines; once per metric, before its samples
+    void family(const char *name, const char *type, const char *help) {
+      snprintf(mLine, sizeof(mLine), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+      mWrite(mLine);
+    }
+
+    // labels is empty or like "stage=\"fetch\""
+    void sample(const char *name, const char *labels, double value) {
+      snprintf(mLine, sizeof(mLine), "%s%s%s%s %.15g\n", name, *labels ? "{" : "", labels, *labels ? "}" : "", value);
+      mWrite(mLine);
+    }
+
+    // Buckets, sum and count of a microsecond histogram, in seconds
+    void histogram(const char *name, const char *labels, const LVMLHistogram &histogram) {
+      const char *separator = *labels ? "," : "";
+      uint32_t cumulative = 0;
+      for (size_t bucket = 0; bucket <= histogram.buckets(); bucket++) {
+        cumulative += histogram.bucketCount(bucket);
+        if (bucket < histogram.buckets()) {
+          snprintf(mLine, sizeof(mLine), "%s_bucket{%s%sle=\"%g\"} %lu\n", name, labels, separator,
+                   histogram.bound(bucket) / 1e6, (unsigned long)cumulative);
+        } else {
+          snprintf(mLine, sizeof(mLine), "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, separator,
+                   (unsigned long)cumulative);
+        }
+        mWrite(mLine);
+      }
+      char sampleName[96];
+      snprintf(sampleName, sizeof(sampleName), "%s_sum", name);
+      sample(sampleName, labels, histogram.sum() / 1e6);
+      snprintf(sampleName, sizeof(sampleName), "%s_count", name);
+      sample(sampleName, labels, histogram.count());
+    }
+
+  private:
+    Write mWrite;
+    char mLine[192];
+};
+
+template <typename Write>
+LVMLMetricsWriter<Write> lvmlMetricsWriter(Write write) {
+  return LVMLMetricsWriter<Write>(write);
+}
+
+// Writes what LVMLMetrics recorded; gauges of the platform are added by the caller
+template <typename Write>
+void lvmlWriteMetrics(LVMLMetricsWriter<Write> &out, const LVMLMetrics &metrics) {
+  static const char *const kStages[] = {"fetch", "preprocess", "create", "total"};
+  static const char *const kSources[] = {"bundle", "prefetch", "download", "failed"};
+  char labels[48];
+
+  out.family("lvml_screen_load_seconds", "histogram", "Screen load latency per stage");
+  for (int stage = 0; stage < LVML_STAGE_COUNT; stage++) {
+    snprintf(labels, sizeof(labels), "stage=\"%s\"", kStages[stage]);
+    out.histogram("lvml_screen_load_seconds", labels, metrics.load[stage]);
+  }
+  out.family("lvml_screen_loads_total", "counter", "Screen loads by result");
+  out.sample("lvml_screen_loads_total", "result=\"ok\"", metrics.loadsOk);
+  out.sample("lvml_screen_loads_total", "result=\"failed\"", metrics.loadsFailed);
+
+  out.family("lvml_images_total", "counter", "Images of loaded screens by source; bundle and prefetch are cache hits");
+  for (int source = 0; source < LVML_IMAGE_SOURCE_COUNT; source++) {
+    snprintf(labels, sizeof(labels), "source=\"%s\"", kSources[source]);
+    out.sample("lvml_images_total", labels, metrics.images[source]);
+  }
+  out.family("lvml_image_descriptors_total", "counter", "Image descriptor lookups; reused ones keep their LVGL registration");
+  out.sample("lvml_image_descriptors_total", "result=\"reused\"", metrics.descriptorsReused);
+  out.sample("lvml_image_descriptors_total", "result=\"created\"", metrics.descriptorsCreated);
+
+  out.family("lvml_frame_seconds", "histogram", "Frame time from render start to the last flush");
+  out.histogram("lvml_frame_seconds", "", metrics.frame);
+  out.family("lvml_flush_seconds", "histogram", "Time of one display flush");
+  out.histogram("lvml_flush_seconds", "", metrics.flush);
+  out.family("lvml_touch_latency_seconds", "histogram", "Time from a touch press to the end of the next frame");
+  out.histogram("lvml_touch_latency_seconds", "", metrics.touch);
+}
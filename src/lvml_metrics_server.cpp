@@ -0,0 +1,93 @@
+#include "lvml_metrics_server.h"
+
+LVMLMetricsServer::LVMLMetricsServer(LVML &lvml, uint16_t port) : mLvml(lvml), mServer(port) {
+  mScrapes = 0;
+  mLastScrapeMicros = 0;
+}
+
+void LVMLMetricsServer::begin() {
+  mServer.on("/metrics", HTTP_GET, [this]() { handleMetrics(); });
+  mServer.onNotFound([this]() { mServer.send(404, "text/plain", "Not found\n"); });
+  mServer.begin();
+  LVML_LOGI("Metrics: http://%s:%d/metrics", WiFi.localIP().toString().c_str(), LVML_METRICS_PORT);
+}
+
+void LVMLMetricsServer::loop() {
+  mServer.handleClient();
+}
+
+void LVMLMetricsServer::handleMetrics() {
+  unsigned long start = micros();
+  mScrapes++;
+  mServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  mServer.send(200, "text/plain; version=0.0.4", "");
+
+  // Lines are collected into chunks of about a TCP segment
+  char chunk[1024];
+  size_t used = 0;
+  auto out = lvmlMetricsWriter([&](const char *text) {
+    size_t length = strlen(text);
+    if (used + length > sizeof(chunk)) {
+      mServer.sendContent(chunk, used);
+      used = 0;
+    }
+    memcpy(chunk + used, text, length);
+    used += length;
+  });
+
+  lvmlWriteMetrics(out, LVMLMetrics::instance());
+
+  out.family("lvml_navigations_total", "counter", "Screen loads started by load_screen taps or navigateTo()");
+  out.sample("lvml_navigations_total", "", mLvml.navigations());
+  out.family("lvml_navigations_coalesced_total", "counter", "Taps merged into a load that was still pending");
+  out.sample("lvml_navigations_coalesced_total", "", mLvml.coalescedNavigations());
+  out.family("lvml_last_navigation_seconds", "gauge", "Tap-to-screen time of the last navigation");
+  out.sample("lvml_last_navigation_seconds", "", mLvml.lastNavigationMs() / 1e3);
+  out.family("lvml_components", "gauge", "Screen components registered with LVGL");
+  out.sample("lvml_components", "", mLvml.componentCount());
+  out.family("lvml_image_descriptors", "gauge", "Image descriptors held");
+  out.sample("lvml_image_descriptors", "", mLvml.imageDescriptorCount());
+
+  out.family("lvml_heap_free_bytes", "gauge", "Free heap");
+  out.sample("lvml_heap_free_bytes", "region=\"internal\"", heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+  out.sample("lvml_heap_free_bytes", "region=\"psram\"", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+  out.family("lvml_heap_min_free_bytes", "gauge", "Least free heap since boot");
+  out.sample("lvml_heap_min_free_bytes", "region=\"internal\"", heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
+  out.sample("lvml_heap_min_free_bytes", "region=\"psram\"", heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+  out.family("lvml_heap_largest_free_block_bytes", "gauge", "Largest free heap block");
+  out.sample("lvml_heap_largest_free_block_bytes", "region=\"internal\"",
+             heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+  out.sample("lvml_heap_largest_free_block_bytes", "region=\"psram\"",
+             heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM));
+
+  LVMLHeapStats lvglHeap = lvmlLvglHeapStats();
+  out.family("lvml_lvgl_heap_size_bytes", "gauge", "Size of LVGL's heap");
+  out.sample("lvml_lvgl_heap_size_bytes", "", lvglHeap.total);
+  out.family("lvml_lvgl_heap_used_bytes", "gauge", "Bytes in use in LVGL's heap");
+  out.sample("lvml_lvgl_heap_used_bytes", "", lvglHeap.used);
+  out.family("lvml_lvgl_heap_peak_bytes", "gauge", "Most bytes ever in use in LVGL's heap");
+  out.sample("lvml_lvgl_heap_peak_bytes", "", lvglHeap.peak);
+  out.family("lvml_lvgl_heap_fragmentation_ratio", "gauge", "Share of free LVGL heap outside the largest block");
+  out.sample("lvml_lvgl_heap_fragmentation_ratio", "", lvglHeap.fragmentation / 100.0);
+
+  LVMLLogStats log = LVMLLog::instance().stats();
+  out.family("lvml_log_calls_total", "counter", "Log calls above the log level");
+  out.sample("lvml_log_calls_total", "", log.calls);
+  out.family("lvml_log_dropped_total", "counter", "Log lines dropped because the log buffer was full");
+  out.sample("lvml_log_dropped_total", "", log.dropped);
+
+  out.family("lvml_wifi_rssi_dbm", "gauge", "WiFi signal strength");
+  out.sample("lvml_wifi_rssi_dbm", "", WiFi.RSSI());
+  out.family("lvml_uptime_seconds", "gauge", "Time since boot");
+  out.sample("lvml_uptime_seconds", "", millis() / 1e3);
+  out.family("lvml_metrics_scrapes_total", "counter", "Scrapes of this endpoint");
+  out.sample("lvml_metrics_scrapes_total", "", mScrapes);
+  out.family("lvml_metrics_scrape_seconds", "gauge", "Time the previous scrape took to serve");
+  out.sample("lvml_metrics_scrape_seconds", "", mLastScrapeMicros / 1e6);
+
+  if (used > 0) {
+    mServer.sendContent(chunk, used);
+  }
+  mServer.sendContent("");
+  mLastScrapeMicros = micros() - start;
+}
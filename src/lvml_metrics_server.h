@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+
+#include "lvml.h"
+
+// Port of the metrics endpoint (Prometheus' node exporter uses the same)
+#ifndef LVML_METRICS_PORT
+#define LVML_METRICS_PORT 9100
+#endif
+
+// Serves GET /metrics in the Prometheus text format: the load, frame and
+// touch histograms and cache counters of LVMLMetrics, plus registry sizes,
+// heap and LVGL heap use, log and WiFi figures read when scraped. Nothing
+// is formatted between scrapes, and a scrape streams the text in small
+// chunks instead of building it in memory, so it can stay on in
+// production. tools/lvml_metrics.py scrapes and checks it.
+class LVMLMetricsServer {
+  public:
+    explicit LVMLMetricsServer(LVML &lvml, uint16_t port = LVML_METRICS_PORT);
+
+    // Call once WiFi is connected
+    void begin();
+
+    // Call from the main loop
+    void loop();
+
+  private:
+    void handleMetrics();
+
+    LVML &mLvml;
+    WebServer mServer;
+    uint32_t mScrapes;
+    unsigned long mLastScrapeMicros;
+};
@@ -0,0 +1,148 @@
+#include "lvml_prefetch.h"
+#include "lvml_arena.h"
+#include "lvml_log.h"
+
+LVMLImagePrefetcher::LVMLImagePrefetcher(FetchFunction fetch) {
+  mFetch = fetch;
+  mTask = nullptr;
+  mMutex = xSemaphoreCreateMutex();
+  mRequests = 0;
+  mHits = 0;
+}
+
+LVMLImagePrefetcher::~LVMLImagePrefetcher() {
+  if (mTask) {
+    vTaskDelete(mTask);
+  }
+  for (Entry &entry : mEntries) {
+    free(entry.data);
+  }
+  vSemaphoreDelete(mMutex);
+}
+
+void LVMLImagePrefetcher::request(const String &url) {
+  xSemaphoreTake(mMutex, portMAX_DELAY);
+  Entry *entry = find(url);
+  if (entry && entry->state == ABANDONED) {
+    // Still downloading for a request that was dropped; claim it again
+    entry->state = LOADING;
+  } else if (!entry) {
+    mEntries.push_back({url, QUEUED, nullptr, 0});
+  }
+  mRequests++;
+  xSemaphoreGive(mMutex);
+
+  if (!mTask) {
+    xTaskCreatePinnedToCore(taskMain, "lvml_prefetch", 8192, this, 1, &mTask, LVML_PREFETCH_CORE);
+  }
+  xTaskNotifyGive(mTask);
+}
+
+uint8_t* LVMLImagePrefetcher::take(const String &url, size_t *size, uint32_t timeoutMs) {
+  unsigned long start = millis();
+  xSemaphoreTake(mMutex, portMAX_DELAY);
+  for (;;) {
+    Entry *entry = find(url);
+    if (!entry || entry->state == ABANDONED) {
+      xSemaphoreGive(mMutex);
+      return nullptr;
+    }
+    if (entry->state == QUEUED) {
+      // The task is busy with other images; fetching this one on the
+      // caller's side runs in parallel rather than behind them
+      mEntries.erase(mEntries.begin() + (entry - mEntries.data()));
+      xSemaphoreGive(mMutex);
+      return nullptr;
+    }
+    if (entry->state == DONE) {
+      uint8_t *data = entry->data;
+      *size = entry->size;
+      mEntries.erase(mEntries.begin() + (entry - mEntries.data()));
+      if (data) mHits++;
+      xSemaphoreGive(mMutex);
+      LVML_LOGD("Prefetched image %s: %d bytes, waited %lu ms", url.c_str(),
+                data ? (int)*size : -1, millis() - start);
+      return data;
+    }
+    if (millis() - start >= timeoutMs) {
+      LVML_LOGW("Prefetch of %s timed out", url.c_str());
+      entry->state = ABANDONED;
+      xSemaphoreGive(mMutex);
+      return nullptr;
+    }
+    xSemaphoreGive(mMutex);
+    delay(2);
+    xSemaphoreTake(mMutex, portMAX_DELAY);
+  }
+}
+
+void LVMLImagePrefetcher::clear() {
+  xSemaphoreTake(mMutex, portMAX_DELAY);
+  std::vector<Entry> kept;
+  for (Entry &entry : mEntries) {
+    if (entry.state == LOADING || entry.state == ABANDONED) {
+      entry.state = ABANDONED;
+      kept.push_back(entry);
+    } else {
+      free(entry.data);
+    }
+  }
+  mEntries.swap(kept);
+  mRequests = 0;
+  mHits = 0;
+  xSemaphoreGive(mMutex);
+}
+
+LVMLImagePrefetcher::Entry* LVMLImagePrefetcher::find(const String &url) {
+  for (Entry &entry : mEntries) {
+    if (entry.url == url) return &entry;
+  }
+  return nullptr;
+}
+
+void LVMLImagePrefetcher::taskMain(void *arg) {
+  ((LVMLImagePrefetcher*)arg)->run();
+}
+
+void LVMLImagePrefetcher::run() {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    String url;
+    while (next(url)) {
+      size_t size = 0;
+      // Same region as the screen arena the image is copied into, so a
+      // prefetch does not hold internal RAM while the screen is parsed
+      uint8_t *data = mFetch(url, &size, LVML_ARENA_PSRAM);
+      finish(url, data, size);
+    }
+  }
+}
+
+bool LVMLImagePrefetcher::next(String &url) {
+  xSemaphoreTake(mMutex, portMAX_DELAY);
+  for (Entry &entry : mEntries) {
+    if (entry.state == QUEUED) {
+      entry.state = LOADING;
+      url = entry.url;
+      xSemaphoreGive(mMutex);
+      return true;
+    }
+  }
+  xSemaphoreGive(mMutex);
+  return false;
+}
+
+void LVMLImagePrefetcher::finish(const String &url, uint8_t *data, size_t size) {
+  xSemaphoreTake(mMutex, portMAX_DELAY);
+  Entry *entry = find(url);
+  if (entry && entry->state == LOADING) {
+    entry->state = DONE;
+    entry->data = data;
+    entry->size = size;
+  } else {
+    // Nobody wants it any more
+    if (entry) mEntries.erase(mEntries.begin() + (entry - mEntries.data()));
+    free(data);
+  }
+  xSemaphoreGive(mMutex);
+}
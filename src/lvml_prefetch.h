@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// How long loadImage() waits for a download the prefetcher already started
+#ifndef LVML_PREFETCH_TIMEOUT_MS
+#define LVML_PREFETCH_TIMEOUT_MS 10000
+#endif
+
+// Core of the download task; the Arduino loop and LVGL run on core 1
+#ifndef LVML_PREFETCH_CORE
+#define LVML_PREFETCH_CORE 0
+#endif
+
+// Downloads images on a background task while the screen XML is still
+// arriving. loadImage() takes finished downloads from here and waits for
+// those in flight instead of fetching them a second time.
+class LVMLImagePrefetcher {
+  public:
+    // Downloads url into a malloc()ed buffer, in PSRAM if psram is set
+    typedef uint8_t* (*FetchFunction)(const String &url, size_t *size, bool psram);
+
+    explicit LVMLImagePrefetcher(FetchFunction fetch);
+    ~LVMLImagePrefetcher();
+
+    // Queues a download unless url is already queued; starts the task on
+    // first use
+    void request(const String &url);
+
+    // Hands over the data for url (release with free()), waiting up to
+    // timeoutMs if it is being downloaded. Returns nullptr if url was not
+    // requested, failed, or is still queued, in which case the caller
+    // downloads it without waiting for the queue.
+    uint8_t* take(const String &url, size_t *size, uint32_t timeoutMs = LVML_PREFETCH_TIMEOUT_MS);
+
+    // Drops all requests and unclaimed data; running downloads are freed
+    // when they finish
+    void clear();
+
+    // Requests made and downloads taken since the last clear()
+    size_t requests() const { return mRequests; }
+    size_t hits() const { return mHits; }
+
+  private:
+    enum State { QUEUED, LOADING, DONE, ABANDONED };
+
+    struct Entry {
+      String url;
+      State state;
+      uint8_t *data;
+      size_t size;
+    };
+
+    static void taskMain(void *arg);
+    void run();
+    bool next(String &url);
+    void finish(const String &url, uint8_t *data, size_t size);
+    Entry* find(const String &url);
+
+    FetchFunction mFetch;
+    TaskHandle_t mTask;
+    SemaphoreHandle_t mMutex;
+    std::vector<Entry> mEntries;
+    size_t mRequests;
+    size_t mHits;
+};
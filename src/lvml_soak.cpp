@@ -0,0 +1,88 @@
+#include "lvml_soak.h"
+
+LVMLSoak::LVMLSoak(LVML &lvml, const String &homeUrl) : mLvml(lvml), mHomeUrl(homeUrl) {
+  mAtHome = false;
+  mTaps = 0;
+  mSeenNavigations = lvml.navigations();
+  mLastLoad = millis();
+  mLastTap = 0;
+  mWaiting = false;
+  mFinished = false;
+}
+
+void LVMLSoak::loop() {
+  if (mFinished) return;
+
+  if (mWaiting) {
+    if (mLvml.navigations() == mSeenNavigations) {
+      if (millis() - mLastTap >= LVML_SOAK_TAP_TIMEOUT_MS) {
+        LVML_LOGW("SOAK stuck: no navigation %d ms after %s", LVML_SOAK_TAP_TIMEOUT_MS,
+                  mAtHome ? "going home" : "a tap");
+        mFinished = true;
+      }
+      return;
+    }
+    mSeenNavigations = mLvml.navigations();
+    mWaiting = false;
+    mLastLoad = millis();
+    report();
+    if (mSeenNavigations >= LVML_SOAK_NAVIGATIONS) {
+      LVML_LOGI("SOAK done navigations=%u taps=%u coalesced=%u", (unsigned)mSeenNavigations,
+                (unsigned)mTaps, (unsigned)mLvml.coalescedNavigations());
+      mFinished = true;
+    }
+    return;
+  }
+
+  if (millis() - mLastLoad >= LVML_SOAK_INTERVAL_MS) {
+    tap();
+  }
+}
+
+void LVMLSoak::collectTargets(lv_obj_t *obj) {
+  for (uint32_t i = 0; i < lv_obj_get_event_count(obj); i++) {
+    if (lv_event_dsc_get_cb(lv_obj_get_event_dsc(obj, i)) == LVML::loadScreenCallback) {
+      mTargets.push_back(obj);
+      break;
+    }
+  }
+  for (uint32_t i = 0; i < lv_obj_get_child_count(obj); i++) {
+    collectTargets(lv_obj_get_child(obj, i));
+  }
+}
+
+void LVMLSoak::tap() {
+  mTargets.clear();
+  collectTargets(lv_screen_active());
+  if (mTargets.empty()) {
+    // A dead end in the screen graph: go back like a Back key would
+    if (mAtHome) {
+      LVML_LOGW("SOAK stuck: no load_screen widget on the home screen");
+      mFinished = true;
+      return;
+    }
+    mLvml.navigateTo(mHomeUrl);
+    mAtHome = true;
+    mWaiting = true;
+    mLastTap = millis();
+    return;
+  }
+  mAtHome = false;
+
+  // A storm taps before the first load ran, so only the last one loads
+  int taps = random(LVML_SOAK_STORM_EVERY) == 0 ? 2 + random(3) : 1;
+  for (int i = 0; i < taps; i++) {
+    lv_obj_send_event(mTargets[random(mTargets.size())], LV_EVENT_CLICKED, NULL);
+    mTaps++;
+  }
+  mWaiting = true;
+  mLastTap = millis();
+}
+
+void LVMLSoak::report() {
+  LVMLMemoryUse use = lvmlMemoryInUse(lvmlLvglHeapStats());
+  LVML_LOGI("SOAK n=%u ms=%lu components=%u descriptors=%u internal=%d largest=%d psram=%d lvgl=%d",
+            (unsigned)mSeenNavigations, mLvml.lastNavigationMs(), (unsigned)mLvml.componentCount(),
+            (unsigned)mLvml.imageDescriptorCount(), (int)use.internal,
+            (int)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL), (int)use.psram, (int)use.lvgl);
+}
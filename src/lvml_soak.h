@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+#include <lvgl.h>
+#include <vector>
+
+#include "lvml.h"
+
+// Navigations one soak run makes before it reports and stops
+#ifndef LVML_SOAK_NAVIGATIONS
+#define LVML_SOAK_NAVIGATIONS 2000
+#endif
+
+// Pause between a finished load and the next tap
+#ifndef LVML_SOAK_INTERVAL_MS
+#define LVML_SOAK_INTERVAL_MS 50
+#endif
+
+// A tap not followed by a navigation within this time ends the run as
+// stuck, e.g. when the handler listens for another trigger than clicked
+#ifndef LVML_SOAK_TAP_TIMEOUT_MS
+#define LVML_SOAK_TAP_TIMEOUT_MS 30000
+#endif
+
+// One navigation in this many is a storm: several taps in a row before the
+// first load has run, as from an impatient user
+#ifndef LVML_SOAK_STORM_EVERY
+#define LVML_SOAK_STORM_EVERY 5
+#endif
+
+// Navigation storm for soak tests (firmware built with -D LVML_SOAK). It
+// taps random load_screen widgets of the screen on display through the same
+// event path as the touch screen, goes back to homeUrl from screens without
+// any, and logs one "SOAK" line per finished load: latency, LVML's
+// registries and memory use. tools/lvml_soak.py reads the lines from the
+// serial port and fails the run on growth or latency drift.
+class LVMLSoak {
+  public:
+    LVMLSoak(LVML &lvml, const String &homeUrl);
+
+    // Call from the main loop after lv_timer_handler()
+    void loop();
+    bool finished() const { return mFinished; }
+
+  private:
+    void collectTargets(lv_obj_t *obj);
+    void tap();
+    void report();
+
+    LVML &mLvml;
+    String mHomeUrl;
+    bool mAtHome;
+    std::vector<lv_obj_t*> mTargets;
+    uint32_t mTaps;
+    uint32_t mSeenNavigations;
+    unsigned long mLastLoad;
+    unsigned long mLastTap;
+    bool mWaiting;
+    bool mFinished;
+};
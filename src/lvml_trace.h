@@ -0,0 +1,177 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Trace spans of screen loads and of the display loop. Built with
+// LVML_TRACE 1, LVML_TRACE_SCOPE("name") records how long the rest of its
+// block takes into a ring of the last LVML_TRACE_EVENTS spans, which
+// exports as Chrome trace JSON (chrome://tracing, ui.perfetto.dev). With
+// LVML_TRACE 0 (the default) the macro expands to nothing and no buffer
+// exists.
+#ifndef LVML_TRACE
+#define LVML_TRACE 0
+#endif
+
+// Spans kept; a power of two
+#ifndef LVML_TRACE_EVENTS
+#define LVML_TRACE_EVENTS 1024
+#endif
+
+#if LVML_TRACE
+
+#include <atomic>
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#else
+#include <chrono>
+#endif
+
+static_assert((LVML_TRACE_EVENTS & (LVML_TRACE_EVENTS - 1)) == 0, "LVML_TRACE_EVENTS must be a power of two");
+
+struct LVMLTraceEvent {
+  const char *name;                // string literal, never copied
+  uint32_t start;                  // microseconds
+  uint32_t duration;
+  std::atomic<uint32_t> sequence;  // position + 1 once written, 0 while being written
+  uint8_t thread;                  // CPU core on the device
+};
+
+// Lock-free ring: each span claims a slot with one atomic add, so code on
+// both cores records without taking a lock. Old spans are overwritten.
+class LVMLTrace {
+  public:
+    constexpr LVMLTrace() : mHead(0), mPaused(false), mEvents() {}
+
+    static LVMLTrace& instance() {
+      static LVMLTrace trace;
+      return trace;
+    }
+
+    static uint32_t now() {
+#ifdef ARDUINO
+      return (uint32_t)esp_timer_get_time();
+#else
+      using namespace std::chrono;
+      return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void record(const char *name, uint32_t start, uint32_t end) {
+      if (mPaused.load(std::memory_order_relaxed)) return;
+      uint32_t position = mHead.fetch_add(1, std::memory_order_relaxed);
+      LVMLTraceEvent &event = mEvents[position & (LVML_TRACE_EVENTS - 1)];
+      event.sequence.store(0, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      event.name = name;
+      event.start = start;
+      event.duration = end - start;
+#ifdef ARDUINO
+      event.thread = (uint8_t)xPortGetCoreID();
+#else
+      event.thread = 0;
+#endif
+      event.sequence.store(position + 1, std::memory_order_release);
+    }
+
+    // Spans recorded since start, including overwritten ones
+    uint32_t recorded() const { return mHead.load(std::memory_order_relaxed); }
+
+    // Writes the ring as Chrome trace JSON through write(const char*).
+    // Recording pauses meanwhile; a span half written when the export
+    // starts, or overwritten while it is copied, is left out.
+    template <typename Write>
+    void exportJson(Write write) {
+      mPaused.store(true, std::memory_order_relaxed);
+      uint32_t head = mHead.load(std::memory_order_acquire);
+      uint32_t first = head > LVML_TRACE_EVENTS ? head - LVML_TRACE_EVENTS : 0;
+      char line[160];
+      write("{\"traceEvents\":[");
+      for (int core = 0; core < 2; core++) {
+        snprintf(line, sizeof(line),
+                 "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"core %d\"}}",
+                 core ? "," : "", core, core);
+        write(line);
+      }
+      // Times count from the earliest start, so the 32-bit clock may wrap
+      uint32_t base = 0;
+      bool haveBase = false;
+      Span span;
+      for (uint32_t position = first; position < head; position++) {
+        if (!read(position, span)) continue;
+        if (!haveBase || (int32_t)(span.start - base) < 0) base = span.start;
+        haveBase = true;
+      }
+      for (uint32_t position = first; position < head; position++) {
+        if (!read(position, span)) continue;
+        snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%ld,\"dur\":%lu,\"pid\":1,\"tid\":%u}",
+                 span.name, (long)(int32_t)(span.start - base), (unsigned long)span.duration,
+                 (unsigned)span.thread);
+        write(line);
+      }
+      snprintf(line, sizeof(line), "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded\":%lu}}\n",
+               (unsigned long)head);
+      write(line);
+      mPaused.store(false, std::memory_order_relaxed);
+    }
+
+  private:
+    struct Span {
+      const char *name;
+      uint32_t start;
+      uint32_t duration;
+      uint8_t thread;
+    };
+
+    // Copies the span at position, checking its sequence before and after
+    // as a seqlock reader does: a core still recording when the export
+    // paused may be writing the slot. False if it is unwritten or changed.
+    bool read(uint32_t position, Span &span) const {
+      const LVMLTraceEvent &event = mEvents[position & (LVML_TRACE_EVENTS - 1)];
+      if (event.sequence.load(std::memory_order_acquire) != position + 1) return false;
+      span.name = event.name;
+      span.start = event.start;
+      span.duration = event.duration;
+      span.thread = event.thread;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return event.sequence.load(std::memory_order_relaxed) == position + 1;
+    }
+
+    std::atomic<uint32_t> mHead;
+    std::atomic<bool> mPaused;
+    LVMLTraceEvent mEvents[LVML_TRACE_EVENTS];
+};
+
+// Records the time from its construction to the end of the block
+class LVMLTraceScope {
+  public:
+    explicit LVMLTraceScope(const char *name) : mName(name), mStart(LVMLTrace::now()) {}
+    ~LVMLTraceScope() { LVMLTrace::instance().record(mName, mStart, LVMLTrace::now()); }
+    LVMLTraceScope(const LVMLTraceScope &) = delete;
+    LVMLTraceScope& operator=(const LVMLTraceScope &) = delete;
+
+  private:
+    const char *mName;
+    uint32_t mStart;
+};
+
+#ifdef ARDUINO
+// Prints the ring between "TRACE BEGIN" and "TRACE END" lines, which
+// tools/lvml_trace.py cuts out of the serial log
+inline void lvmlTraceDump(Print &out) {
+  out.println("TRACE BEGIN");
+  LVMLTrace::instance().exportJson([&out](const char *text) { out.print(text); });
+  out.println("TRACE END");
+}
+#endif
+
+#define LVML_TRACE_CONCAT_(a, b) a##b
+#define LVML_TRACE_CONCAT(a, b) LVML_TRACE_CONCAT_(a, b)
+#define LVML_TRACE_SCOPE(name) LVMLTraceScope LVML_TRACE_CONCAT(lvmlTraceScope, __LINE__)(name)
+
+#else
+
+#define LVML_TRACE_SCOPE(name) do {} while (0)
+
+#endif
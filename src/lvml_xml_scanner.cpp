@@ -0,0 +1,201 @@
+#include "lvml_xml_scanner.h"
+#include "lvml_log.h"
+
+LVMLXmlScanner::LVMLXmlScanner(LVMLXmlListener *listener) : mListener(listener) {
+  mTag.reserve(256);
+  reset();
+}
+
+void LVMLXmlScanner::reset() {
+  mState = TEXT;
+  mQuote = 0;
+  mTail = 0;
+  mOverflow = false;
+  mElements = 0;
+  mTag.clear();
+}
+
+void LVMLXmlScanner::feed(const char *data, size_t length) {
+  const char *end = data + length;
+  while (data < end) {
+    if (mState == TEXT) {
+      // Text is skipped wholesale up to the next tag
+      const char *lt = (const char *)memchr(data, '<', end - data);
+      if (!lt) return;
+      data = lt + 1;
+      mState = MARKUP;
+      mTag.clear();
+      mOverflow = false;
+      continue;
+    }
+
+    char c = *data++;
+    uint16_t tail = mTail;
+    mTail = (uint16_t)((mTail << 8) | (uint8_t)c);
+
+    switch (mState) {
+      case MARKUP:
+        if (mTag.empty()) {
+          if (c == '?') {
+            mState = INSTRUCTION;
+            mTail = 0;
+          } else if (c == '/') {
+            mState = END_TAG;
+          } else if (c == '!') {
+            mTag.push_back(c);
+          } else if (c == '>') {
+            mState = TEXT;
+          } else {
+            mState = TAG;
+            mTag.push_back(c);
+          }
+        } else {
+          // "<!" opens a comment, a CDATA section or a declaration
+          mTag.push_back(c);
+          size_t n = mTag.size();
+          bool comment = n <= 3 && memcmp(mTag.data(), "!--", n) == 0;
+          bool cdata = n <= 8 && memcmp(mTag.data(), "![CDATA[", n) == 0;
+          if (comment && n == 3) {
+            mState = COMMENT;
+            mTail = 0;
+          } else if (cdata && n == 8) {
+            mState = CDATA;
+            mTail = 0;
+          } else if (!comment && !cdata) {
+            mState = c == '>' ? TEXT : DECLARATION;
+          }
+        }
+        break;
+
+      case TAG:
+        if (mQuote) {
+          if (c == mQuote) mQuote = 0;
+        } else if (c == '"' || c == '\'') {
+          mQuote = c;
+        } else if (c == '>') {
+          emitTag();
+          mState = TEXT;
+          break;
+        }
+        if (mTag.size() < LVML_XML_SCANNER_MAX_TAG) {
+          mTag.push_back(c);
+        } else {
+          mOverflow = true;
+        }
+        break;
+
+      case END_TAG:
+      case DECLARATION:
+        if (c == '>') mState = TEXT;
+        break;
+
+      case COMMENT:
+        if (c == '>' && tail == (('-' << 8) | '-')) mState = TEXT;
+        break;
+
+      case CDATA:
+        if (c == '>' && tail == ((']' << 8) | ']')) mState = TEXT;
+        break;
+
+      case INSTRUCTION:
+        if (c == '>' && (tail & 0xff) == '?') mState = TEXT;
+        break;
+
+      case TEXT:
+        break;
+    }
+  }
+}
+
+void LVMLXmlScanner::emitTag() {
+  if (mOverflow || mTag.empty()) {
+    LVML_LOGW("XML scanner: skipped a tag of more than %d bytes", LVML_XML_SCANNER_MAX_TAG);
+    return;
+  }
+  mTag.push_back(0);
+
+  // Split "name a="1" b='2'/" in place into NUL-terminated pieces
+  char *p = mTag.data();
+  char *name = p;
+  while (*p && !isspace((uint8_t)*p) && *p != '/') p++;
+  bool more = *p != 0;
+  *p = 0;
+  if (more) p++;
+
+  mAttrs.clear();
+  while (more) {
+    while (isspace((uint8_t)*p)) p++;
+    if (!*p || *p == '/') break;
+    char *attrName = p;
+    while (*p && *p != '=' && !isspace((uint8_t)*p)) p++;
+    char *nameEnd = p;
+    while (isspace((uint8_t)*p)) p++;
+    if (*p != '=') break;
+    p++;
+    while (isspace((uint8_t)*p)) p++;
+    char quote = *p;
+    if (quote != '"' && quote != '\'') break;
+    char *value = ++p;
+    while (*p && *p != quote) p++;
+    if (!*p) break;
+    *nameEnd = 0;
+    *p++ = 0;
+    mAttrs.push_back(attrName);
+    mAttrs.push_back(decodeEntities(value));
+  }
+
+  if (!*name) return;
+  mElements++;
+  mListener->startElement(name, mAttrs.data(), mAttrs.size() / 2);
+}
+
+char *LVMLXmlScanner::decodeEntities(char *value) {
+  static const struct {
+    const char *name;
+    char ch;
+  } entities[] = {{"amp;", '&'}, {"lt;", '<'}, {"gt;", '>'}, {"quot;", '"'}, {"apos;", '\''}};
+
+  char *out = strchr(value, '&');
+  if (!out) return value;
+  const char *in = out;
+  while (*in) {
+    if (*in == '&') {
+      bool decoded = false;
+      for (const auto &entity : entities) {
+        size_t n = strlen(entity.name);
+        if (strncmp(in + 1, entity.name, n) == 0) {
+          *out++ = entity.ch;
+          in += n + 1;
+          decoded = true;
+          break;
+        }
+      }
+      // Character references outside ASCII are left as they are
+      if (!decoded && in[1] == '#') {
+        char *numEnd;
+        long code = in[2] == 'x' ? strtol(in + 3, &numEnd, 16) : strtol(in + 2, &numEnd, 10);
+        if (*numEnd == ';' && code > 0 && code < 128) {
+          *out++ = (char)code;
+          in = numEnd + 1;
+          decoded = true;
+        }
+      }
+      if (decoded) continue;
+    }
+    *out++ = *in++;
+  }
+  *out = 0;
+  return value;
+}
+
+size_t LVMLScanStream::write(const uint8_t *buffer, size_t size) {
+  size_t written = mSink.write(buffer, size);
+
+  // The sink may have reallocated its buffer, so continue by offset
+  size_t length = mOutput.length();
+  if (length > mScanned) {
+    mScanner.feed(mOutput.c_str() + mScanned, length - mScanned);
+    mScanned = length;
+  }
+  return written;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+#include "lvml_buffer.h"
+
+// Tags longer than this (name plus attributes) are skipped by the scanner
+#ifndef LVML_XML_SCANNER_MAX_TAG
+#define LVML_XML_SCANNER_MAX_TAG 2048
+#endif
+
+// Receives the start tags found by LVMLXmlScanner. Attributes come as
+// name/value pairs (attrs[2 * i], attrs[2 * i + 1]) with entities decoded;
+// the pointers are only valid during the call.
+class LVMLXmlListener {
+  public:
+    virtual ~LVMLXmlListener() {}
+    virtual void startElement(const char *name, const char *const *attrs, size_t count) = 0;
+};
+
+// Push-style XML scanner: feed() it the body in chunks as they arrive and it
+// reports each start tag as soon as its closing '>' is in, so work that only
+// needs tags and attributes can begin before the download completes. It does
+// not validate; text, end tags, comments, CDATA, declarations and processing
+// instructions are skipped. tinyxml2 still parses the complete document.
+class LVMLXmlScanner {
+  public:
+    explicit LVMLXmlScanner(LVMLXmlListener *listener);
+
+    void reset();
+    void feed(const char *data, size_t length);
+
+    // Start tags reported since the last reset
+    size_t elements() const { return mElements; }
+
+  private:
+    enum State {
+      TEXT,
+      MARKUP,       // after '<', deciding what follows
+      TAG,          // start tag, collected into mTag
+      END_TAG,
+      COMMENT,      // <!-- ... -->
+      CDATA,        // <![CDATA[ ... ]]>
+      DECLARATION,  // <!DOCTYPE ... >
+      INSTRUCTION,  // <? ... ?>
+    };
+
+    void emitTag();
+    static char *decodeEntities(char *value);
+
+    LVMLXmlListener *mListener;
+    State mState;
+    char mQuote;        // quote character while inside an attribute value
+    uint16_t mTail;     // last two characters, for "-->", "]]>" and "?>"
+    bool mOverflow;
+    size_t mElements;
+    std::vector<char> mTag;
+    std::vector<const char*> mAttrs;
+};
+
+// Stream for HTTPClient::writeToStream() that passes the body on to a sink
+// appending to `output` (an LVMLBufferStream or LVMLInflateStream) and scans
+// whatever the sink added, so compressed bodies are scanned as they inflate
+class LVMLScanStream : public Stream {
+  public:
+    LVMLScanStream(Stream &sink, const LVMLBuffer &output, LVMLXmlScanner &scanner)
+      : mSink(sink), mOutput(output), mScanner(scanner), mScanned(0) {}
+
+    size_t write(uint8_t byte) override { return write(&byte, 1); }
+    size_t write(const uint8_t *buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+  private:
+    Stream &mSink;
+    const LVMLBuffer &mOutput;
+    LVMLXmlScanner &mScanner;
+    size_t mScanned;
+};
@@ -6,6 +6,10 @@
 
 #include "WifiConfig.h"
 #include "lvml.h"
+#include "lvml_metrics_server.h"
+#ifdef LVML_SOAK
+#include "lvml_soak.h"
+#endif
 
 const char* ssid = WIFI_SSID;
 const char* password = WIFI_PASSWORD;
@@ -13,6 +17,10 @@ const char* password = WIFI_PASSWORD;
 TFT_eSPI tft;
 GT911 gt911;
 LVML lvml;
+LVMLMetricsServer metrics(lvml);
+#ifdef LVML_SOAK
+LVMLSoak soak(lvml, "http://192.168.1.105:8866/main.xml");
+#endif
 
 #define BUF_ROWS 120
 static lv_color_t *buf1 = NULL; // Primary buffer (will be allocated in PSRAM)
@@ -21,6 +29,13 @@ static lv_color_t *buf2 = NULL; // Secondary buffer (will be allocated in PSRAM)
 // Tick callback function for LVGL
 static uint32_t my_tick(void) { return millis(); }
 
+// Frame and touch timing for the metrics endpoint; 0 when not running
+static unsigned long frameStart = 0;
+static unsigned long touchStart = 0;
+static bool touchPressed = false;
+
+static void render_start_cb(lv_event_t *e) { frameStart = micros(); }
+
 // Touch input callback (dummy implementation - can be enhanced later)
 
 void touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data) {
@@ -37,14 +52,19 @@ void touch_read_cb(lv_indev_t *indev, lv_indev_data_t *data) {
     data->point.x = x;
     data->point.y = y;
     data->state = LV_INDEV_STATE_PRESSED;
+    if (!touchPressed) touchStart = micros();
+    touchPressed = true;
 
     // Serial.printf("Touch: (%d,%d)\n", x, y);
   } else {
     data->state = LV_INDEV_STATE_RELEASED;
+    touchPressed = false;
   }
 }
 
 void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
+  LVML_TRACE_SCOPE("flush");
+  unsigned long flushStart = micros();
   uint32_t w = (area->x2 - area->x1 + 1);
   uint32_t h = (area->y2 - area->y1 + 1);
 
@@ -56,6 +76,15 @@ void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
   tft.pushPixels((uint16_t *)px_map, w * h);
   tft.endWrite();
 
+  unsigned long now = micros();
+  LVMLMetrics &recorded = LVMLMetrics::instance();
+  recorded.flush.observe(now - flushStart);
+  if (lv_display_flush_is_last(disp)) {
+    if (frameStart) recorded.frame.observe(now - frameStart);
+    if (touchStart) recorded.touch.observe(now - touchStart);
+    frameStart = touchStart = 0;
+  }
+
   // Tell LVGL we're done flushing this area
   lv_display_flush_ready(disp);
 }
@@ -63,6 +92,7 @@ void my_disp_flush(lv_display_t *disp, const lv_area_t *area, uint8_t *px_map) {
 void setup() {
   Serial.begin(115200);
   delay(1000);
+  lvmlLogBegin(Serial);
 
   Serial.println("Starting...");
   Serial.println("Build timestamp: " + String(__DATE__) + " " + String(__TIME__));
@@ -110,6 +140,7 @@ void setup() {
   }
   Serial.println("Display created - setting flush callback...");
   lv_display_set_flush_cb(disp, my_disp_flush);
+  lv_display_add_event_cb(disp, render_start_cb, LV_EVENT_RENDER_START, NULL);
   Serial.println("Flush callback set, setting buffers...");
   lv_display_set_buffers(disp, buf1, buf2, 320 * BUF_ROWS * sizeof(lv_color_t),
                          LV_DISPLAY_RENDER_MODE_PARTIAL);
@@ -127,10 +158,49 @@ void setup() {
   Serial.printf("Loading main.xml...\n");
   lvml.begin();
   lvml.loadScreenUrl("http://192.168.1.105:8866/main.xml");
-  
+#ifdef LVML_DEV
+  lvml.beginDataChannel("192.168.1.105", 8867);
+  lvml.beginHotReload();
+#endif
+  metrics.begin();
+
 }
 
 void loop() {
-  lv_timer_handler();
+  // Serial commands: '0'-'4' set the log level (none, error, warn, info,
+  // debug), 'l' prints log statistics, 't' dumps the trace
+  if (Serial.available()) {
+    int command = Serial.read();
+    if (command >= '0' && command <= '4') {
+      lvmlLogSetLevel(command - '0');
+    } else if (command == 'l') {
+      // Written past the log buffer, which may be the full one; the log
+      // task is held back so the line is not cut into one of its own
+      LVMLLogStats stats = LVMLLog::instance().stats();
+      lvmlLogPauseOutput();
+      Serial.printf("Log: %u call(s), %u dropped, %u ns per call, buffer %u of %u bytes at most\n",
+                    (unsigned)stats.calls, (unsigned)stats.dropped, (unsigned)stats.meanNs,
+                    (unsigned)stats.highWater, (unsigned)LVML_LOG_BUFFER_SIZE);
+      lvmlLogResumeOutput();
+#if LVML_TRACE
+    } else if (command == 't') {
+      lvmlLogPauseOutput();
+      lvmlTraceDump(Serial);
+      lvmlLogResumeOutput();
+#endif
+    }
+  }
+  {
+    LVML_TRACE_SCOPE("lvml_loop");
+    lvml.loop();
+  }
+  metrics.loop();
+  {
+    LVML_TRACE_SCOPE("timer_handler");
+    lv_timer_handler();
+  }
+#ifdef LVML_SOAK
+  soak.loop();
+#endif
   delay(5);
 }
\ No newline at end of file
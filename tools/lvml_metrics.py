@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Scraper for the device's /metrics endpoint (or `lvmlc metrics --serve`).
+
+Fetches the Prometheus text exposition, checks that it is well formed and
+prints a summary: latency quantiles estimated from the histograms, image
+cache and descriptor reuse ratios, and the heap gauges.
+
+    python tools/lvml_metrics.py http://192.168.1.50:9100/metrics
+    python tools/lvml_metrics.py --file metrics.txt
+
+Exits with 1 if the exposition is malformed, so it can run in CI against
+`lvmlc metrics --serve`.
+"""
+
+import argparse
+import math
+import re
+import sys
+import urllib.request
+
+SAMPLE = re.compile(r'^([a-zA-Z_:][a-zA-Z0-9_:]*)(?:\{(.*)\})?\s+(\S+)$')
+LABEL = re.compile(r'([a-zA-Z_][a-zA-Z0-9_]*)="((?:[^"\\]|\\.)*)"')
+
+
+def parse(text):
+    """Returns ({name: type}, [(name, labels, value)], [errors])."""
+    types = {}
+    samples = []
+    errors = []
+    for number, line in enumerate(text.splitlines(), 1):
+        if not line.strip():
+            continue
+        if line.startswith("# TYPE "):
+            parts = line.split()
+            if len(parts) != 4:
+                errors.append(f"line {number}: bad TYPE line")
+            else:
+                types[parts[2]] = parts[3]
+            continue
+        if line.startswith("#"):
+            continue
+        match = SAMPLE.match(line)
+        if not match:
+            errors.append(f"line {number}: cannot parse {line!r}")
+            continue
+        name, labels, value = match.groups()
+        try:
+            value = float(value)
+        except ValueError:
+            errors.append(f"line {number}: bad value {value!r}")
+            continue
+        samples.append((name, dict(LABEL.findall(labels or "")), value))
+    return types, samples, errors
+
+
+def family_of(name, types):
+    for suffix in ("_bucket", "_sum", "_count"):
+        if name.endswith(suffix) and types.get(name[: -len(suffix)]) == "histogram":
+            return name[: -len(suffix)]
+    return name
+
+
+def histograms(types, samples):
+    """{(name, labels without le): {"buckets": [(le, count)], "sum", "count"}}"""
+    result = {}
+    for name, labels, value in samples:
+        family = family_of(name, types)
+        if family == name:
+            continue
+        key = (family, tuple(sorted((k, v) for k, v in labels.items() if k != "le")))
+        entry = result.setdefault(key, {"buckets": [], "sum": None, "count": None})
+        if name.endswith("_bucket"):
+            entry["buckets"].append((float(labels["le"]), value))
+        elif name.endswith("_sum"):
+            entry["sum"] = value
+        else:
+            entry["count"] = value
+    return result
+
+
+def validate(types, samples, hists):
+    errors = []
+    untyped = set()
+    for name, labels, value in samples:
+        family = family_of(name, types)
+        if family not in types and family not in untyped:
+            untyped.add(family)
+            errors.append(f"{family}: no TYPE line")
+        if name.endswith("_total") and value < 0:
+            errors.append(f"{name}: negative counter")
+    for (name, labels), entry in hists.items():
+        where = name + ("{" + ",".join(f"{k}={v}" for k, v in labels) + "}" if labels else "")
+        buckets = entry["buckets"]
+        if not buckets or buckets[-1][0] != math.inf:
+            errors.append(f"{where}: no +Inf bucket")
+            continue
+        if any(b[1] > a[1] for b, a in zip(buckets, buckets[1:])) or \
+                any(b[0] >= a[0] for b, a in zip(buckets, buckets[1:])):
+            errors.append(f"{where}: buckets are not cumulative")
+        if entry["count"] is None or entry["sum"] is None:
+            errors.append(f"{where}: missing _sum or _count")
+        elif buckets[-1][1] != entry["count"]:
+            errors.append(f"{where}: +Inf bucket {buckets[-1][1]:g} != _count {entry['count']:g}")
+    return errors
+
+
+def quantile(q, buckets):
+    """Linear interpolation within the bucket, as Prometheus' histogram_quantile()."""
+    total = buckets[-1][1]
+    if total == 0:
+        return None
+    rank = q * total
+    lower_bound, lower_count = 0.0, 0.0
+    for bound, count in buckets:
+        if count >= rank:
+            if bound == math.inf:
+                return lower_bound  # beyond the largest finite bucket
+            return lower_bound + (bound - lower_bound) * (rank - lower_count) / max(count - lower_count, 1e-12)
+        lower_bound, lower_count = bound, count
+    return lower_bound
+
+
+def ms(seconds):
+    return "-" if seconds is None else f"{seconds * 1e3:.1f}"
+
+
+def ratio(hits, total):
+    return "-" if total == 0 else f"{100.0 * hits / total:.0f}%"
+
+
+def summarize(samples, hists):
+    print(f"{'histogram':<42} {'count':>7} {'p50 ms':>8} {'p90 ms':>8} {'p99 ms':>8} {'mean ms':>8}")
+    for (name, labels), entry in sorted(hists.items()):
+        label = name + ("{" + ",".join(f"{k}={v}" for k, v in labels) + "}" if labels else "")
+        count = entry["count"] or 0
+        mean = entry["sum"] / count if count else None
+        p50, p90, p99 = (quantile(q, entry["buckets"]) for q in (0.5, 0.9, 0.99))
+        print(f"{label:<42} {count:>7.0f} {ms(p50):>8} {ms(p90):>8} {ms(p99):>8} {ms(mean):>8}")
+
+    def value(name, **labels):
+        return sum(v for n, l, v in samples
+                   if n == name and all(l.get(k) == want for k, want in labels.items()))
+
+    images = value("lvml_images_total")
+    cached = value("lvml_images_total", source="bundle") + value("lvml_images_total", source="prefetch")
+    reused = value("lvml_image_descriptors_total", result="reused")
+    print()
+    print(f"screen loads: {value('lvml_screen_loads_total', result='ok'):.0f} ok, "
+          f"{value('lvml_screen_loads_total', result='failed'):.0f} failed")
+    print(f"image cache hits: {ratio(cached, images)} of {images:.0f} "
+          f"({value('lvml_images_total', source='failed'):.0f} failed)")
+    print(f"descriptor reuse: {ratio(reused, value('lvml_image_descriptors_total'))}")
+    for name, labels, v in samples:
+        if "heap" in name:
+            region = f"{{{labels['region']}}}" if "region" in labels else ""
+            print(f"{name}{region}: {v:.6g}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("url", nargs="?", help="metrics URL, e.g. http://<device>:9100/metrics")
+    parser.add_argument("--file", help="read a saved exposition instead")
+    parser.add_argument("--timeout", type=float, default=5.0)
+    args = parser.parse_args()
+    if args.file:
+        with open(args.file) as f:
+            text = f.read()
+    elif args.url:
+        with urllib.request.urlopen(args.url, timeout=args.timeout) as response:
+            text = response.read().decode()
+    else:
+        parser.error("a URL or --file is needed")
+
+    types, samples, errors = parse(text)
+    hists = histograms(types, samples)
+    errors += validate(types, samples, hists)
+    summarize(samples, hists)
+    for error in errors:
+        print(f"invalid: {error}", file=sys.stderr)
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
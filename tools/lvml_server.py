@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Development server for LVML.
+
+Serves a directory (lvml_web by default) like `python -m http.server` and
+announces changed files to devices over server-sent events, so screens and
+images reload on the device as soon as they are saved.
+
+    python tools/lvml_server.py --root lvml_web --port 8866
+
+Devices connect once to /__lvml/events and receive one event per changed
+file, e.g. `data: /step1.xml`.
+
+XML and other text files are sent gzip-compressed to clients that accept it.
+`--throttle` limits the send rate to emulate slow links when comparing
+compressed and identity transfers on the device.
+"""
+
+import argparse
+import functools
+import gzip
+import os
+import queue
+import threading
+import time
+from http.server import SimpleHTTPRequestHandler, ThreadingHTTPServer
+
+EVENT_PATH = "/__lvml/events"
+COMPRESSIBLE = (".xml", ".txt", ".json", ".html")
+
+
+class ChangeBroadcaster:
+    """Watches the served directory and fans changed paths out to listeners."""
+
+    def __init__(self, root, interval):
+        self.root = root
+        self.interval = interval
+        self.listeners = []
+        self.lock = threading.Lock()
+
+    def subscribe(self):
+        q = queue.Queue()
+        with self.lock:
+            self.listeners.append(q)
+        return q
+
+    def unsubscribe(self, q):
+        with self.lock:
+            self.listeners.remove(q)
+
+    def publish(self, path):
+        with self.lock:
+            for q in self.listeners:
+                q.put(path)
+
+    def snapshot(self):
+        mtimes = {}
+        for dirpath, _, filenames in os.walk(self.root):
+            for name in filenames:
+                full = os.path.join(dirpath, name)
+                try:
+                    mtimes[full] = os.stat(full).st_mtime_ns
+                except OSError:
+                    pass
+        return mtimes
+
+    def run(self):
+        previous = self.snapshot()
+        while True:
+            time.sleep(self.interval)
+            current = self.snapshot()
+            for full, mtime in current.items():
+                if previous.get(full) != mtime:
+                    rel = os.path.relpath(full, self.root).replace(os.sep, "/")
+                    print(f"changed: /{rel}")
+                    self.publish("/" + rel)
+            previous = current
+
+
+class LVMLRequestHandler(SimpleHTTPRequestHandler):
+    broadcaster = None
+    compress = True
+    throttle = 0  # KiB/s, 0 for unlimited
+
+    def do_GET(self):
+        if self.path == EVENT_PATH:
+            return self.send_events()
+        accepts_gzip = "gzip" in self.headers.get("Accept-Encoding", "")
+        if self.compress and accepts_gzip and self.path.split("?")[0].endswith(COMPRESSIBLE):
+            return self.send_gzipped()
+        return super().do_GET()
+
+    def send_gzipped(self):
+        try:
+            with open(self.translate_path(self.path), "rb") as f:
+                data = f.read()
+        except OSError:
+            return self.send_error(404, "File not found")
+
+        body = gzip.compress(data, 9, mtime=0)
+        self.send_response(200)
+        self.send_header("Content-Type", self.guess_type(self.path))
+        self.send_header("Content-Encoding", "gzip")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Vary", "Accept-Encoding")
+        self.end_headers()
+        self.write_throttled(body)
+        print(f"gzip {self.path}: {len(data)} -> {len(body)} bytes")
+
+    def copyfile(self, source, outputfile):
+        self.write_throttled(source.read())
+
+    def write_throttled(self, data):
+        if not self.throttle:
+            self.wfile.write(data)
+            return
+        chunk = 512
+        for i in range(0, len(data), chunk):
+            self.wfile.write(data[i:i + chunk])
+            self.wfile.flush()
+            time.sleep(chunk / (self.throttle * 1024))
+
+    def send_events(self):
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.end_headers()
+
+        q = self.broadcaster.subscribe()
+        try:
+            while True:
+                try:
+                    path = q.get(timeout=15)
+                    self.wfile.write(f"data: {path}\n\n".encode())
+                except queue.Empty:
+                    # Comment line keeps idle connections from being dropped
+                    self.wfile.write(b": keepalive\n\n")
+                self.wfile.flush()
+        except (BrokenPipeError, ConnectionResetError):
+            pass
+        finally:
+            self.broadcaster.unsubscribe(q)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--root", default="lvml_web", help="directory to serve")
+    parser.add_argument("--port", type=int, default=8866)
+    parser.add_argument("--interval", type=float, default=0.5, help="file watch interval in seconds")
+    parser.add_argument("--no-gzip", action="store_true", help="always send identity encoding")
+    parser.add_argument("--throttle", type=float, default=0, help="limit send rate to KiB/s")
+    args = parser.parse_args()
+
+    root = os.path.abspath(args.root)
+    broadcaster = ChangeBroadcaster(root, args.interval)
+    threading.Thread(target=broadcaster.run, daemon=True).start()
+
+    LVMLRequestHandler.broadcaster = broadcaster
+    LVMLRequestHandler.compress = not args.no_gzip
+    LVMLRequestHandler.throttle = args.throttle
+    handler = functools.partial(LVMLRequestHandler, directory=root)
+    server = ThreadingHTTPServer(("", args.port), handler)
+    server.daemon_threads = True
+    print(f"Serving {root} on port {args.port}, events at {EVENT_PATH}")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Soak test judge for LVML navigation storms.
+
+Firmware built from the `soak` environment (-D LVML_SOAK) taps random
+load_screen widgets thousands of times, storms of several taps included, and
+logs one line per finished load through LVML's log:
+
+    [812.330] SOAK n=412 ms=96 components=1 descriptors=4 internal=88412 largest=110580 psram=61440 lvgl=94208
+
+This script reads those lines from the serial port (or a saved log), prints
+latency percentiles and the registries and memory over time, and exits with
+status 1 when something grows without bound or loads get slower:
+
+    python tools/lvml_soak.py --port /dev/ttyACM0
+    python tools/lvml_soak.py --log soak.txt
+
+The first --warmup loads fill caches (image descriptors, pools, arenas that
+reach their working size) and are only shown, not judged.
+"""
+
+import argparse
+import re
+import sys
+
+LINE = re.compile(r"SOAK n=(\d+) ms=(\d+) components=(\d+) descriptors=(\d+) "
+                  r"internal=(-?\d+) largest=(\d+) psram=(-?\d+) lvgl=(-?\d+)")
+FIELDS = ("n", "ms", "components", "descriptors", "internal", "largest", "psram", "lvgl")
+MEMORY = ("internal", "psram", "lvgl")
+
+
+def read_lines(args):
+    if args.log:
+        with open(args.log, errors="replace") as f:
+            yield from f
+        return
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed to read the serial port (pip install pyserial)")
+    with serial.Serial(args.port, args.baud, timeout=args.timeout) as port:
+        while True:
+            raw = port.readline()
+            if not raw:
+                print("no output from the device", file=sys.stderr)
+                return
+            yield raw.decode(errors="replace")
+
+
+DROPPED = re.compile(r"\((\d+) log line\(s\) dropped\)")
+
+
+def collect(lines, echo):
+    """Returns (samples, done, stuck line or None, log lines dropped)."""
+    samples, done, stuck, dropped = [], False, None, 0
+    for line in lines:
+        line = line.rstrip()
+        if echo:
+            print(line)
+        match = LINE.search(line)
+        if match:
+            samples.append(dict(zip(FIELDS, map(int, match.groups()))))
+        elif "SOAK done" in line:
+            done = True
+            break
+        elif "SOAK stuck" in line:
+            stuck = line[line.index("SOAK stuck"):]
+            break
+        elif DROPPED.search(line):
+            dropped += int(DROPPED.search(line).group(1))
+    return samples, done, stuck, dropped
+
+
+def percentile(values, p):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p / 100))]
+
+
+def slope(xs, ys):
+    """Least-squares growth of ys per step of xs."""
+    mean_x, mean_y = sum(xs) / len(xs), sum(ys) / len(ys)
+    var = sum((x - mean_x) ** 2 for x in xs)
+    if not var:
+        return 0.0
+    return sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys)) / var
+
+
+def report_over_time(samples, rows):
+    print(f"{'n':>6} {'ms':>6} {'comp':>5} {'desc':>5} {'internal':>10} {'largest':>10} {'psram':>10} {'lvgl':>10}")
+    shown = samples[::max(1, len(samples) // rows)]
+    if shown[-1] is not samples[-1]:
+        shown.append(samples[-1])
+    for s in shown:
+        print(f"{s['n']:>6} {s['ms']:>6} {s['components']:>5} {s['descriptors']:>5} {s['internal']:>10} "
+              f"{s['largest']:>10} {s['psram']:>10} {s['lvgl']:>10}")
+
+
+def judge(samples, args):
+    failures = []
+    judged = samples[args.warmup:]
+    if len(judged) < 8:
+        return [f"only {len(judged)} load(s) after the warm-up, not enough to judge"]
+
+    latencies = [s["ms"] for s in judged]
+    print(f"latency ms: p50 {percentile(latencies, 50)}  p90 {percentile(latencies, 90)}  "
+          f"p99 {percentile(latencies, 99)}  max {max(latencies)}")
+
+    # Registries must stay flat: one live component, descriptors bounded by
+    # the images of the screen graph, which the warm-up has visited
+    if max(s["components"] for s in judged) > args.max_components:
+        failures.append(f"component registry reached {max(s['components'] for s in judged)} "
+                        f"(limit {args.max_components})")
+    first_desc, last_desc = judged[0]["descriptors"], judged[-1]["descriptors"]
+    if last_desc > first_desc:
+        failures.append(f"image descriptors grew from {first_desc} to {last_desc} after the warm-up")
+
+    xs = [s["n"] for s in judged]
+    for region in MEMORY:
+        growth = slope(xs, [s[region] for s in judged])
+        print(f"{region:>8}: {growth:+.1f} bytes per load")
+        if growth > args.max_growth:
+            failures.append(f"{region} grows by {growth:.1f} bytes per load (limit {args.max_growth})")
+
+    # Fragmentation: the largest free block should not keep shrinking
+    quarter = max(1, len(judged) // 4)
+    first, last = judged[:quarter], judged[-quarter:]
+    largest_before = sum(s["largest"] for s in first) / len(first)
+    largest_after = sum(s["largest"] for s in last) / len(last)
+    print(f" largest free block: {largest_before:.0f} -> {largest_after:.0f} bytes")
+    if largest_after < largest_before * (1 - args.max_fragmentation):
+        failures.append(f"largest free block shrank from {largest_before:.0f} to {largest_after:.0f} bytes")
+
+    p50_before = percentile([s["ms"] for s in first], 50)
+    p50_after = percentile([s["ms"] for s in last], 50)
+    print(f" latency p50 drift: {p50_before} -> {p50_after} ms")
+    if p50_after > p50_before * (1 + args.max_drift) + 2:
+        failures.append(f"p50 latency drifted from {p50_before} to {p50_after} ms")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the device")
+    source.add_argument("--log", help="saved serial log to judge instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=60, help="seconds without output before giving up")
+    parser.add_argument("--warmup", type=int, default=100, help="loads not judged")
+    parser.add_argument("--max-components", type=int, default=1)
+    parser.add_argument("--max-growth", type=float, default=16, help="bytes per load per memory region")
+    parser.add_argument("--max-fragmentation", type=float, default=0.2,
+                        help="allowed shrink of the largest free block, as a fraction")
+    parser.add_argument("--max-drift", type=float, default=0.5, help="allowed p50 latency rise, as a fraction")
+    parser.add_argument("--rows", type=int, default=20, help="rows of the over-time table")
+    parser.add_argument("--echo", action="store_true", help="print the device output while reading")
+    args = parser.parse_args()
+
+    samples, done, stuck, dropped = collect(read_lines(args), args.echo)
+    if not samples:
+        sys.exit("no SOAK lines found")
+    report_over_time(samples, args.rows)
+    if dropped:
+        # SOAK lines share the device's log buffer; with some of them lost
+        # the samples are incomplete and not worth judging
+        failures = [f"{dropped} log line(s) dropped on the device; raise LVML_LOG_BUFFER_SIZE or lower the log level"]
+    else:
+        failures = judge(samples, args)
+    if stuck:
+        failures.append(stuck)
+    elif not done:
+        failures.append(f"run ended after {len(samples)} load(s) without finishing")
+
+    for failure in failures:
+        print(f"FAIL: {failure}")
+    print("FAILED" if failures else "PASSED")
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Trace capture for firmware built with LVML_TRACE=1.
+
+Asks the device for its trace ring over serial (or cuts it out of a saved
+log), and writes it as Chrome trace JSON to open in chrome://tracing or
+https://ui.perfetto.dev:
+
+    python tools/lvml_trace.py --port /dev/ttyACM0 trace.json
+    python tools/lvml_trace.py --log serial.txt trace.json
+
+Also prints the total and slowest time per span name.
+"""
+
+import argparse
+import json
+import sys
+import time
+
+
+def read_lines(args):
+    if args.log:
+        with open(args.log, errors="replace") as f:
+            yield from f
+        return
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed to read the serial port (pip install pyserial)")
+    with serial.Serial(args.port, args.baud, timeout=args.timeout) as port:
+        time.sleep(0.2)
+        port.reset_input_buffer()
+        port.write(b"t")
+        while True:
+            raw = port.readline()
+            if not raw:
+                print("no trace from the device", file=sys.stderr)
+                return
+            yield raw.decode(errors="replace")
+
+
+def capture(lines):
+    """Text between the last complete TRACE BEGIN / TRACE END pair."""
+    body, inside, trace = [], False, None
+    for line in lines:
+        line = line.rstrip("\r\n")
+        if line == "TRACE BEGIN":
+            body, inside = [], True
+        elif line == "TRACE END" and inside:
+            trace, inside = "\n".join(body), False
+            if not isinstance(lines, list):
+                break
+        elif inside:
+            body.append(line)
+    return trace
+
+
+def summarize(trace):
+    totals = {}
+    for event in trace["traceEvents"]:
+        if event.get("ph") != "X":
+            continue
+        count, total, slowest = totals.get(event["name"], (0, 0, 0))
+        totals[event["name"]] = (count + 1, total + event["dur"], max(slowest, event["dur"]))
+    print(f"{'span':<16} {'count':>6} {'total ms':>10} {'mean us':>9} {'max us':>9}")
+    for name, (count, total, slowest) in sorted(totals.items(), key=lambda item: -item[1][1]):
+        print(f"{name:<16} {count:>6} {total / 1000:>10.1f} {total / count:>9.0f} {slowest:>9}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the device")
+    source.add_argument("--log", help="saved serial log to read instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=10, help="seconds without output before giving up")
+    parser.add_argument("out", help="Chrome trace JSON file to write")
+    args = parser.parse_args()
+
+    text = capture(list(read_lines(args)) if args.log else read_lines(args))
+    if text is None:
+        sys.exit("no complete trace found")
+    try:
+        trace = json.loads(text)
+    except ValueError as error:
+        sys.exit(f"trace is damaged ({error}); serial output interleaved with it?")
+    with open(args.out, "w") as f:
+        json.dump(trace, f)
+    print(f"{len(trace['traceEvents'])} event(s) written to {args.out}")
+    summarize(trace)
+
+
+if __name__ == "__main__":
+    main()
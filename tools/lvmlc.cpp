@@ -0,0 +1,1484 @@
+/*
+  lvmlc - host-side tool for preparing lvml_web content.
+
+  Build (from the repository root):
+      g++ -std=c++17 -O2 -Ilib/tinyxml2 -Isrc tools/lvmlc.cpp src/lvml_buffer.cpp lib/tinyxml2/tinyxml2.cpp -lz -o lvmlc
+
+  Usage:
+      lvmlc bundle <root> [screen.xml...]
+          Writes <screen>.lvmlb next to each screen (every .xml under <root>
+          if none are given), containing the XML and all referenced images.
+
+      lvmlc compile <root> [screen.xml...]
+          Writes <screen>.lvmlc next to each screen: the view with interned
+          names, typed numbers and colors, substituted constants and
+          resolved image paths.
+
+      lvmlc check <root> [screen.xml...]
+          Validates screens against the LVGL widget schema and checks that
+          images and load_screen targets exist.
+
+      lvmlc minify <root> <out>
+          Validates every screen, then writes a minified copy of <root> to
+          <out>: no comments, whitespace or XML declaration, default
+          attributes folded, relative src/user_data paths made absolute.
+
+      lvmlc bench [widgets] [iterations]
+          Parses a generated screen with <widgets> widgets (default 2000)
+          <iterations> times (default 200) per tinyxml2 memory
+          configuration and reports time and allocations per parse, then
+          compares linear, hashed and interned attribute lookup, and the
+          cost of a deferred log call against formatting it in place, and
+          the wall-clock time of an identity against a deflated body at a
+          few link rates with the inflater fed as the body arrives, and
+          allocations and bytes copied per screen load by the String
+          pipeline and by LVMLBuffer.
+
+      lvmlc mem <root> [--max-peak=<bytes>] [screen.xml...]
+          Measures heap use of the XML stages of a screen load (read, parse,
+          rewrite, release) through an allocator hook and prints it in the
+          device's "Memory" log format. Fails if a screen's peak exceeds
+          --max-peak, or if memory is still in use after the release.
+
+      lvmlc trace <root> <out.json> [screen.xml...]
+          Runs the same stages with the firmware's trace spans and writes
+          them as Chrome trace JSON, then prints the cost of one span.
+
+      lvmlc metrics <root> [--loads=N] [--serve=<port>] [--scrapes=N] [screen.xml...]
+          Loads every screen N times (default 10) with the firmware's load
+          histograms and prints the /metrics exposition, or serves it on
+          127.0.0.1:<port> until --scrapes requests were answered (default
+          forever) for checking a scraper against it.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#include "tinyxml2.h"
+#include "lvml_buffer.h"
+#include "lvml_bundle.h"
+#include "lvml_compiled.h"
+#include "lvml_load_memory.h"
+#include "lvml_metrics.h"
+
+#define LVML_TRACE 1
+#include "lvml_trace.h"
+#include "lvml_log.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static bool readFile(const fs::path &path, std::string &out) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  return true;
+}
+
+static bool writeFile(const fs::path &path, const std::string &data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(data.data(), (std::streamsize)data.size());
+  return (bool)out;
+}
+
+// Path of a file relative to the served root, as the device requests it
+static std::string serverPath(const fs::path &root, const fs::path &file) {
+  return "/" + fs::relative(file, root).generic_string();
+}
+
+// Resolves an image src the way LVML::resolveImageUrl does; returns an empty
+// string for absolute URLs, which are left for the device to fetch
+static std::string resolveSrc(const std::string &screenPath, const std::string &src) {
+  if (src.rfind("http://", 0) == 0 || src.rfind("https://", 0) == 0) return "";
+  if (!src.empty() && src[0] == '/') return src;
+  return screenPath.substr(0, screenPath.rfind('/') + 1) + src;
+}
+
+static void collectImages(tinyxml2::XMLElement *element, const std::string &screenPath,
+                          std::vector<std::string> &images) {
+  if (strcmp(element->Name(), "lv_image") == 0) {
+    const char *src = element->Attribute("src");
+    std::string path = src ? resolveSrc(screenPath, src) : "";
+    bool seen = false;
+    for (const std::string &image : images) seen |= image == path;
+    if (!path.empty() && !seen) images.push_back(path);
+  }
+  for (tinyxml2::XMLElement *child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+    collectImages(child, screenPath, images);
+  }
+}
+
+static std::vector<fs::path> findScreens(const fs::path &root) {
+  std::vector<fs::path> screens;
+  for (const auto &entry : fs::recursive_directory_iterator(root)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".xml") screens.push_back(entry.path());
+  }
+  std::sort(screens.begin(), screens.end());
+  return screens;
+}
+
+//--------------------------------
+// bundle
+//--------------------------------
+static void putU16(std::string &out, uint16_t v) {
+  out.push_back((char)(v & 0xFF));
+  out.push_back((char)(v >> 8));
+}
+
+static void putU32(std::string &out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out.push_back((char)((v >> (8 * i)) & 0xFF));
+}
+
+static bool buildBundle(const fs::path &root, const fs::path &screen) {
+  std::string screenPath = serverPath(root, screen);
+  std::vector<std::string> paths = {screenPath};
+  std::vector<std::string> payloads(1);
+  if (!readFile(screen, payloads[0])) {
+    fprintf(stderr, "%s: cannot read\n", screen.c_str());
+    return false;
+  }
+
+  tinyxml2::XMLDocument doc;
+  if (doc.Parse(payloads[0].data(), payloads[0].size()) != tinyxml2::XML_SUCCESS || !doc.RootElement()) {
+    fprintf(stderr, "%s: %s\n", screen.c_str(), doc.ErrorStr());
+    return false;
+  }
+  std::vector<std::string> images;
+  collectImages(doc.RootElement(), screenPath, images);
+  for (const std::string &image : images) {
+    std::string data;
+    if (!readFile(root / image.substr(1), data)) {
+      fprintf(stderr, "%s: missing image %s\n", screen.c_str(), image.c_str());
+      return false;
+    }
+    paths.push_back(image);
+    payloads.push_back(data);
+  }
+
+  // Index first, so payload offsets are known before they are written
+  size_t indexSize = 8;
+  for (const std::string &path : paths) indexSize += 10 + path.size() + 1;
+
+  std::vector<uint32_t> offsets;
+  size_t pos = indexSize;
+  for (const std::string &payload : payloads) {
+    pos = (pos + LVML_BUNDLE_ALIGN - 1) & ~(size_t)(LVML_BUNDLE_ALIGN - 1);
+    offsets.push_back((uint32_t)pos);
+    pos += payload.size() + 1;
+  }
+
+  std::string out(LVML_BUNDLE_MAGIC);
+  putU16(out, LVML_BUNDLE_VERSION);
+  putU16(out, (uint16_t)paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    putU32(out, offsets[i]);
+    putU32(out, (uint32_t)payloads[i].size());
+    putU16(out, (uint16_t)paths[i].size());
+    out += paths[i];
+    out.push_back('\0');
+  }
+  for (size_t i = 0; i < payloads.size(); i++) {
+    out.resize(offsets[i], '\0');
+    out += payloads[i];
+    out.push_back('\0');
+  }
+
+  fs::path target = screen;
+  target.replace_extension(LVML_BUNDLE_EXTENSION);
+  if (!writeFile(target, out)) {
+    fprintf(stderr, "%s: cannot write\n", target.c_str());
+    return false;
+  }
+
+  LVMLBundleEntry check[LVML_BUNDLE_MAX_ENTRIES];
+  if (lvmlBundleParse((const uint8_t *)out.data(), out.size(), check, LVML_BUNDLE_MAX_ENTRIES) != paths.size()) {
+    fprintf(stderr, "%s: bundle does not read back\n", target.c_str());
+    return false;
+  }
+  printf("%-28s %zu image(s), %zu bytes, %zu request(s) saved\n",
+         serverPath(root, target).c_str(), images.size(), out.size(), images.size());
+  return true;
+}
+
+static int cmdBundle(int argc, char **argv) {
+  if (argc < 1) return -1;
+  fs::path root = argv[0];
+  std::vector<fs::path> screens;
+  for (int i = 1; i < argc; i++) screens.push_back(argv[i]);
+  if (screens.empty()) screens = findScreens(root);
+
+  bool ok = true;
+  for (const fs::path &screen : screens) ok &= buildBundle(root, screen);
+  return ok ? 0 : 1;
+}
+
+//--------------------------------
+// compile
+//--------------------------------
+class Compiler {
+  public:
+    Compiler(const std::string &screenPath) : mScreenPath(screenPath) {}
+
+    bool compile(tinyxml2::XMLElement *root, std::string &out, std::string &error) {
+      tinyxml2::XMLElement *view = nullptr;
+      for (tinyxml2::XMLElement *section = root->FirstChildElement(); section; section = section->NextSiblingElement()) {
+        if (strcmp(section->Name(), "view") == 0) {
+          view = section;
+        } else if (strcmp(section->Name(), "consts") == 0) {
+          for (tinyxml2::XMLElement *c = section->FirstChildElement(); c; c = c->NextSiblingElement()) {
+            if (c->Attribute("name") && c->Attribute("value")) {
+              mConsts[std::string("#") + c->Attribute("name")] = c->Attribute("value");
+            }
+          }
+        } else {
+          // Styles, subjects and the like need a registered component
+          error = std::string("<") + section->Name() + "> needs the XML loader";
+          return false;
+        }
+      }
+      if (!view) {
+        error = "no <view>";
+        return false;
+      }
+
+      std::string nodes;
+      compileNode(view, true, nodes);
+
+      out = LVML_COMPILED_MAGIC;
+      putU16(out, LVML_COMPILED_VERSION);
+      putU16(out, (uint16_t)mStrings.size());
+      for (const std::string &str : mStrings) {
+        putU16(out, (uint16_t)str.size());
+        out += str;
+        out.push_back('\0');
+      }
+      out += nodes;
+      return true;
+    }
+
+    size_t nodeCount() const { return mNodes; }
+
+  private:
+    uint16_t intern(const std::string &str) {
+      auto it = mIds.find(str);
+      if (it != mIds.end()) return it->second;
+      uint16_t id = (uint16_t)mStrings.size();
+      mStrings.push_back(str);
+      mIds[str] = id;
+      return id;
+    }
+
+    // Types a value only if printing it back reproduces the original text
+    static uint8_t typeValue(const std::string &value, uint32_t &out) {
+      char buf[32];
+      if (value == "content") {
+        out = 0;
+        return LVMLC_CONTENT;
+      }
+      char *end = nullptr;
+      if (value.size() == 8 && value.compare(0, 2, "0x") == 0) {
+        unsigned long color = strtoul(value.c_str() + 2, &end, 16);
+        snprintf(buf, sizeof(buf), "0x%06lX", color);
+        if (*end == '\0' && value == buf) {
+          out = (uint32_t)color;
+          return LVMLC_COLOR;
+        }
+      }
+      long number = strtol(value.c_str(), &end, 10);
+      if (end != value.c_str() && (*end == '\0' || (*end == '%' && end[1] == '\0'))) {
+        snprintf(buf, sizeof(buf), *end == '%' ? "%ld%%" : "%ld", number);
+        if (value == buf) {
+          out = (uint32_t)(int32_t)number;
+          return *end == '%' ? LVMLC_PERCENT : LVMLC_INT;
+        }
+      }
+      return LVMLC_STRING;
+    }
+
+    void compileNode(tinyxml2::XMLElement *element, bool isView, std::string &out) {
+      mNodes++;
+      std::string tag = element->Name();
+      if (isView) {
+        const char *extends = element->Attribute("extends");
+        tag = extends ? extends : "lv_obj";
+      }
+
+      std::string attrs;
+      uint16_t attrCount = 0;
+      for (const tinyxml2::XMLAttribute *attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+        std::string name = attr->Name();
+        if (isView && name == "extends") continue;
+        std::string value = attr->Value();
+        auto c = mConsts.find(value);
+        if (c != mConsts.end()) value = c->second;
+
+        uint32_t raw = 0;
+        uint8_t type = LVMLC_STRING;
+        std::string resolved = tag == "lv_image" && name == "src" ? resolveSrc(mScreenPath, value) : "";
+        if (!resolved.empty()) {
+          type = LVMLC_IMAGE;
+          raw = intern(resolved);
+        } else {
+          type = typeValue(value, raw);
+          if (type == LVMLC_STRING) raw = intern(value);
+        }
+
+        putU16(attrs, intern(name));
+        attrs.push_back((char)type);
+        putU32(attrs, raw);
+        attrCount++;
+      }
+
+      uint16_t childCount = 0;
+      for (tinyxml2::XMLElement *child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+        childCount++;
+      }
+
+      putU16(out, intern(tag));
+      putU16(out, attrCount);
+      putU16(out, childCount);
+      out += attrs;
+      for (tinyxml2::XMLElement *child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+        compileNode(child, false, out);
+      }
+    }
+
+    std::string mScreenPath;
+    std::map<std::string, std::string> mConsts;
+    std::map<std::string, uint16_t> mIds;
+    std::vector<std::string> mStrings;
+    size_t mNodes = 0;
+};
+
+// Walks a compiled screen the way the device does, to prove it reads back
+static bool verifyNode(LVMLCompiledReader *r, uint16_t stringCount) {
+  uint16_t tag, attrCount, childCount;
+  if (!lvmlCompiledNode(r, &tag, &attrCount, &childCount) || tag >= stringCount) return false;
+  for (uint16_t i = 0; i < attrCount; i++) {
+    LVMLCompiledAttr attr;
+    if (!lvmlCompiledAttr(r, &attr) || attr.name >= stringCount) return false;
+  }
+  for (uint16_t i = 0; i < childCount; i++) {
+    if (!verifyNode(r, stringCount)) return false;
+  }
+  return true;
+}
+
+static bool compileScreen(const fs::path &root, const fs::path &screen) {
+  std::string xml;
+  if (!readFile(screen, xml)) {
+    fprintf(stderr, "%s: cannot read\n", screen.c_str());
+    return false;
+  }
+  tinyxml2::XMLDocument doc;
+  if (doc.Parse(xml.data(), xml.size()) != tinyxml2::XML_SUCCESS || !doc.RootElement()) {
+    fprintf(stderr, "%s: %s\n", screen.c_str(), doc.ErrorStr());
+    return false;
+  }
+
+  Compiler compiler(serverPath(root, screen));
+  std::string out;
+  std::string error;
+  if (!compiler.compile(doc.RootElement(), out, error)) {
+    fprintf(stderr, "%s: %s\n", screen.c_str(), error.c_str());
+    return false;
+  }
+
+  LVMLCompiledReader reader;
+  uint16_t stringCount = 0;
+  std::vector<const char *> strings;
+  bool ok = lvmlCompiledOpen(&reader, (const uint8_t *)out.data(), out.size(), &stringCount);
+  strings.resize(stringCount);
+  ok = ok && lvmlCompiledStrings(&reader, strings.data(), stringCount);
+  ok = ok && verifyNode(&reader, stringCount) && reader.pos == out.size();
+  if (!ok) {
+    fprintf(stderr, "%s: compiled screen does not read back\n", screen.c_str());
+    return false;
+  }
+
+  fs::path target = screen;
+  target.replace_extension(LVML_COMPILED_EXTENSION);
+  if (!writeFile(target, out)) {
+    fprintf(stderr, "%s: cannot write\n", target.c_str());
+    return false;
+  }
+  printf("%-28s %zu node(s), %zu strings, %zu -> %zu bytes\n",
+         serverPath(root, target).c_str(), compiler.nodeCount(), (size_t)stringCount, xml.size(), out.size());
+  return true;
+}
+
+static int cmdCompile(int argc, char **argv) {
+  if (argc < 1) return -1;
+  fs::path root = argv[0];
+  std::vector<fs::path> screens;
+  for (int i = 1; i < argc; i++) screens.push_back(argv[i]);
+  if (screens.empty()) screens = findScreens(root);
+
+  bool ok = true;
+  for (const fs::path &screen : screens) ok &= compileScreen(root, screen);
+  return ok ? 0 : 1;
+}
+
+//--------------------------------
+// check / minify
+//--------------------------------
+
+// Attributes every widget accepts (lv_obj), besides style_* and bind_*
+static const char *const kObjAttributes[] = {
+  "name", "x", "y", "width", "height", "align", "styles",
+  "hidden", "clickable", "click_focusable", "checkable", "scrollable", "scroll_elastic",
+  "scroll_momentum", "scroll_one", "scroll_chain_hor", "scroll_chain_ver", "scroll_on_focus",
+  "snappable", "press_lock", "event_bubble", "gesture_bubble", "adv_hittest", "ignore_layout",
+  "floating", "overflow_visible", "flex_in_new_track", "send_draw_task_events",
+  "checked", "focused", "pressed", "disabled", "scrolled", "edited", "hovered",
+  "flex_flow", "flex_grow", "flex_main_place", "flex_cross_place", "flex_track_place",
+  "grid_column_dsc_array", "grid_row_dsc_array", "grid_cell_column_pos", "grid_cell_row_pos",
+  "grid_cell_column_span", "grid_cell_row_span", "grid_cell_x_align", "grid_cell_y_align",
+  "ext_click_area",
+};
+
+// Widget specific attributes; a null list means only the lv_obj ones
+struct WidgetSchema {
+  const char *name;
+  std::vector<const char *> attributes;
+  bool isObject;  // false for sub-elements that configure their parent
+};
+
+static const std::vector<WidgetSchema> &widgetSchemas() {
+  static const std::vector<WidgetSchema> schemas = {
+    {"lv_obj", {}, true},
+    {"lv_button", {}, true},
+    {"lv_label", {"text", "long_mode", "translation_tag"}, true},
+    {"lv_image", {"src", "inner_align", "rotation", "scale_x", "scale_y", "pivot_x", "pivot_y", "offset_x", "offset_y", "antialias"}, true},
+    {"lv_bar", {"min_value", "max_value", "value", "start_value", "mode", "orientation"}, true},
+    {"lv_slider", {"min_value", "max_value", "value", "start_value", "mode", "orientation"}, true},
+    {"lv_arc", {"min_value", "max_value", "value", "start_angle", "end_angle", "bg_start_angle", "bg_end_angle", "rotation", "mode"}, true},
+    {"lv_checkbox", {"text"}, true},
+    {"lv_switch", {"orientation"}, true},
+    {"lv_led", {"color", "brightness"}, true},
+    {"lv_spinner", {"anim_duration", "arc_length"}, true},
+    {"lv_dropdown", {"options", "selected", "text", "symbol", "dir"}, true},
+    {"lv_roller", {"options", "selected", "visible_row_count"}, true},
+    {"lv_textarea", {"text", "placeholder_text", "one_line", "password_mode", "password_show_time", "max_length", "accepted_chars", "text_selection", "cursor_pos"}, true},
+    {"lv_keyboard", {"mode", "popovers", "textarea"}, true},
+    {"lv_buttonmatrix", {"map", "ctrl_map", "selected_button", "one_checked"}, true},
+    {"lv_table", {"column_count", "row_count"}, true},
+    {"lv_tabview", {"active", "tab_bar_position", "tab_bar_size"}, true},
+    {"lv_tabview-tab", {"text"}, true},
+    {"lv_chart", {"type", "point_count", "update_mode", "div_line_count", "hor_div_line_count", "ver_div_line_count"}, true},
+    {"lv_scale", {"mode", "total_tick_count", "major_tick_every", "label_show", "range", "angle_range", "rotation"}, true},
+    {"lv_spangroup", {"overflow", "max_lines", "indent", "mode"}, true},
+    {"lv_canvas", {}, true},
+    {"lv_event-call_function", {"trigger", "callback", "user_data"}, false},
+    {"lv_obj-event_cb", {"trigger", "callback", "user_data"}, false},
+  };
+  return schemas;
+}
+
+static const WidgetSchema *findSchema(const char *name) {
+  for (const WidgetSchema &schema : widgetSchemas()) {
+    if (strcmp(schema.name, name) == 0) return &schema;
+  }
+  return nullptr;
+}
+
+static bool isKnownAttribute(const WidgetSchema &schema, const std::string &attribute) {
+  // "style_bg_color:pressed" selects a part/state; the name is what matters
+  std::string name = attribute.substr(0, attribute.find(':'));
+  if (!schema.isObject) {
+    for (const char *a : schema.attributes) if (name == a) return true;
+    return false;
+  }
+  if (name.rfind("style_", 0) == 0 || name.rfind("bind_", 0) == 0) return true;
+  for (const char *a : kObjAttributes) if (name == a) return true;
+  for (const char *a : schema.attributes) if (name == a) return true;
+  return false;
+}
+
+// Attributes whose value equals LVGL's default and can be dropped
+static bool isDefaultAttribute(const std::string &name, const std::string &value) {
+  static const std::map<std::string, std::string> defaults = {
+    {"x", "0"}, {"y", "0"},
+    {"style_margin_all", "0"}, {"style_margin_left", "0"}, {"style_margin_right", "0"},
+    {"style_margin_top", "0"}, {"style_margin_bottom", "0"},
+    {"style_translate_x", "0"}, {"style_translate_y", "0"},
+    {"hidden", "false"}, {"checked", "false"}, {"disabled", "false"},
+  };
+  auto it = defaults.find(name);
+  return it != defaults.end() && it->second == value;
+}
+
+// Absolute, normalized server path for a reference made from screenPath
+static std::string canonicalPath(const std::string &screenPath, const std::string &ref) {
+  std::string path = resolveSrc(screenPath, ref);
+  if (path.empty()) return ref;
+  return fs::path(path).lexically_normal().generic_string();
+}
+
+struct ScreenReport {
+  int errors = 0;
+  int warnings = 0;
+  size_t nodesBefore = 0;
+  size_t nodesAfter = 0;
+  int folded = 0;
+  int rewritten = 0;
+};
+
+class Validator {
+  public:
+    Validator(const fs::path &root, const fs::path &screen) : mRoot(root), mScreen(screen) {
+      mScreenPath = serverPath(root, screen);
+    }
+
+    void validate(tinyxml2::XMLElement *component, ScreenReport &report) {
+      if (strcmp(component->Name(), "component") != 0) {
+        error(component, report, "root element must be <component>");
+        return;
+      }
+      bool hasView = false;
+      for (tinyxml2::XMLElement *section = component->FirstChildElement(); section; section = section->NextSiblingElement()) {
+        const char *name = section->Name();
+        if (strcmp(name, "view") == 0) {
+          hasView = true;
+          const char *extends = section->Attribute("extends");
+          const WidgetSchema *schema = findSchema(extends ? extends : "lv_obj");
+          validateWidget(section, schema, true, report);
+        } else if (strcmp(name, "consts") != 0 && strcmp(name, "styles") != 0 &&
+                   strcmp(name, "api") != 0 && strcmp(name, "subjects") != 0 &&
+                   strcmp(name, "images") != 0 && strcmp(name, "fonts") != 0) {
+          error(section, report, std::string("unknown section <") + name + ">");
+        }
+      }
+      if (!hasView) error(component, report, "no <view>");
+    }
+
+  private:
+    void validateWidget(tinyxml2::XMLElement *element, const WidgetSchema *schema, bool isView, ScreenReport &report) {
+      if (!schema && !isView) {
+        // Could be a custom component registered elsewhere
+        warning(element, report, std::string("unknown widget <") + element->Name() + ">");
+      }
+      for (const tinyxml2::XMLAttribute *attr = element->FirstAttribute(); attr; attr = attr->Next()) {
+        std::string name = attr->Name();
+        if (isView && name == "extends") continue;
+        if (schema && !isKnownAttribute(*schema, name)) {
+          error(element, report, "unknown attribute " + name + " on <" + element->Name() + ">");
+        }
+      }
+
+      if (strcmp(element->Name(), "lv_image") == 0 && element->Attribute("src")) {
+        checkTarget(element, element->Attribute("src"), report);
+      }
+      if (schema && !schema->isObject) {
+        if (!element->Attribute("callback")) error(element, report, "event without callback");
+        const char *callback = element->Attribute("callback");
+        if (callback && strcmp(callback, "load_screen") == 0) {
+          if (!element->Attribute("user_data")) error(element, report, "load_screen without user_data");
+          else checkTarget(element, element->Attribute("user_data"), report);
+        }
+      }
+
+      for (tinyxml2::XMLElement *child = element->FirstChildElement(); child; child = child->NextSiblingElement()) {
+        validateWidget(child, findSchema(child->Name()), false, report);
+      }
+    }
+
+    void checkTarget(tinyxml2::XMLElement *element, const char *ref, ScreenReport &report) {
+      std::string path = resolveSrc(mScreenPath, ref);
+      if (!path.empty() && !fs::exists(mRoot / path.substr(1))) {
+        error(element, report, std::string("missing file ") + ref);
+      }
+    }
+
+    void error(tinyxml2::XMLElement *element, ScreenReport &report, const std::string &message) {
+      fprintf(stderr, "%s:%d: error: %s\n", mScreen.c_str(), element->GetLineNum(), message.c_str());
+      report.errors++;
+    }
+
+    void warning(tinyxml2::XMLElement *element, ScreenReport &report, const std::string &message) {
+      fprintf(stderr, "%s:%d: warning: %s\n", mScreen.c_str(), element->GetLineNum(), message.c_str());
+      report.warnings++;
+    }
+
+    fs::path mRoot;
+    fs::path mScreen;
+    std::string mScreenPath;
+};
+
+static size_t countNodes(const tinyxml2::XMLNode *node) {
+  size_t count = 1;
+  for (const tinyxml2::XMLNode *child = node->FirstChild(); child; child = child->NextSibling()) {
+    count += countNodes(child);
+  }
+  return count;
+}
+
+static void minifyNode(tinyxml2::XMLNode *node, const std::string &screenPath, ScreenReport &report) {
+  tinyxml2::XMLNode *child = node->FirstChild();
+  while (child) {
+    tinyxml2::XMLNode *next = child->NextSibling();
+    if (child->ToComment() || child->ToDeclaration()) {
+      node->DeleteChild(child);
+    } else {
+      minifyNode(child, screenPath, report);
+    }
+    child = next;
+  }
+
+  tinyxml2::XMLElement *element = node->ToElement();
+  if (!element) return;
+
+  // Only plain LVGL widgets are folded. With styles= the attribute
+  // overrides a style, and a component instance's view may set another
+  // value, so there it is not a default.
+  const WidgetSchema *schema = findSchema(element->Name());
+  bool foldable = schema && schema->isObject && !element->Attribute("styles");
+  std::vector<std::string> drop;
+  for (const tinyxml2::XMLAttribute *attr = element->FirstAttribute(); foldable && attr; attr = attr->Next()) {
+    if (isDefaultAttribute(attr->Name(), attr->Value())) drop.push_back(attr->Name());
+  }
+  for (const std::string &name : drop) {
+    element->DeleteAttribute(name.c_str());
+    report.folded++;
+  }
+
+  const char *ref = nullptr;
+  const char *refName = nullptr;
+  if (strcmp(element->Name(), "lv_image") == 0) {
+    refName = "src";
+  } else if (element->Attribute("callback", "load_screen")) {
+    refName = "user_data";
+  }
+  if (refName && (ref = element->Attribute(refName))) {
+    std::string canonical = canonicalPath(screenPath, ref);
+    if (canonical != ref) {
+      element->SetAttribute(refName, canonical.c_str());
+      report.rewritten++;
+    }
+  }
+}
+
+static bool loadScreen(const fs::path &screen, std::string &xml, tinyxml2::XMLDocument &doc) {
+  if (!readFile(screen, xml)) {
+    fprintf(stderr, "%s: cannot read\n", screen.c_str());
+    return false;
+  }
+  if (doc.Parse(xml.data(), xml.size()) != tinyxml2::XML_SUCCESS || !doc.RootElement()) {
+    fprintf(stderr, "%s: %s\n", screen.c_str(), doc.ErrorStr());
+    return false;
+  }
+  return true;
+}
+
+static int cmdCheck(int argc, char **argv) {
+  if (argc < 1) return -1;
+  fs::path root = argv[0];
+  std::vector<fs::path> screens;
+  for (int i = 1; i < argc; i++) screens.push_back(argv[i]);
+  if (screens.empty()) screens = findScreens(root);
+
+  int errors = 0;
+  for (const fs::path &screen : screens) {
+    std::string xml;
+    tinyxml2::XMLDocument doc;
+    if (!loadScreen(screen, xml, doc)) {
+      errors++;
+      continue;
+    }
+    ScreenReport report;
+    Validator(root, screen).validate(doc.RootElement(), report);
+    errors += report.errors;
+    printf("%-28s %s\n", serverPath(root, screen).c_str(), report.errors ? "FAILED" : "ok");
+  }
+  return errors ? 1 : 0;
+}
+
+static int cmdMinify(int argc, char **argv) {
+  if (argc != 2) return -1;
+  fs::path root = argv[0];
+  fs::path out = argv[1];
+
+  size_t totalBefore = 0;
+  size_t totalAfter = 0;
+  int errors = 0;
+  for (const auto &entry : fs::recursive_directory_iterator(root)) {
+    if (!entry.is_regular_file()) continue;
+    fs::path target = out / fs::relative(entry.path(), root);
+    fs::create_directories(target.parent_path());
+
+    // Everything but screens is copied as is, so <out> can be served directly
+    if (entry.path().extension() != ".xml") {
+      fs::copy_file(entry.path(), target, fs::copy_options::overwrite_existing);
+      continue;
+    }
+
+    std::string xml;
+    tinyxml2::XMLDocument doc(true, tinyxml2::COLLAPSE_WHITESPACE);
+    if (!loadScreen(entry.path(), xml, doc)) {
+      errors++;
+      continue;
+    }
+    ScreenReport report;
+    Validator(root, entry.path()).validate(doc.RootElement(), report);
+    if (report.errors) {
+      errors += report.errors;
+      continue;
+    }
+
+    std::string screenPath = serverPath(root, entry.path());
+    report.nodesBefore = countNodes(&doc) - 1;
+    minifyNode(&doc, screenPath, report);
+    report.nodesAfter = countNodes(&doc) - 1;
+
+    tinyxml2::XMLPrinter printer(nullptr, true);
+    doc.Print(&printer);
+    std::string minified(printer.CStr());
+    if (!writeFile(target, minified)) {
+      fprintf(stderr, "%s: cannot write\n", target.c_str());
+      errors++;
+      continue;
+    }
+
+    totalBefore += xml.size();
+    totalAfter += minified.size();
+    printf("%-28s %5zu -> %5zu bytes (-%2zu%%), %zu -> %zu nodes, %d folded, %d path(s) rewritten\n",
+           screenPath.c_str(), xml.size(), minified.size(), 100 - minified.size() * 100 / xml.size(),
+           report.nodesBefore, report.nodesAfter, report.folded, report.rewritten);
+  }
+  if (totalBefore > 0) {
+    printf("total %zu -> %zu bytes\n", totalBefore, totalAfter);
+  }
+  return errors ? 1 : 0;
+}
+
+//--------------------------------
+// bench
+//--------------------------------
+
+// Heap allocator that counts what tinyxml2 asks for
+class CountingAllocator : public tinyxml2::XMLAllocator {
+  public:
+    void *Allocate(size_t size) override {
+      allocations++;
+      return malloc(size);
+    }
+    void Deallocate(void *mem) override { free(mem); }
+
+    size_t allocations = 0;
+};
+
+// A screen shaped like lvml_web's, scaled up: rows of labelled widgets with
+// the usual mix of layout, style and binding attributes
+static std::string generateScreen(int widgets) {
+  std::string xml = "<component>\n  <consts>\n    <color name=\"accent\" value=\"0x007AFF\"/>\n"
+                    "  </consts>\n  <view width=\"100%\" height=\"100%\" flex_flow=\"column\">\n";
+  static const char *kinds[] = {"lv_label", "lv_button", "lv_bar", "lv_slider", "lv_image"};
+  for (int i = 0; i < widgets; i++) {
+    const char *kind = kinds[i % 5];
+    char line[512];
+    snprintf(line, sizeof(line),
+             "    <%s name=\"w%d\" x=\"%d\" y=\"%d\" width=\"%d\" height=\"content\" "
+             "style_bg_color=\"#accent\" style_radius=\"8\" style_pad_all=\"%d\" "
+             "style_text_color=\"0xFFFFFF\" bind_value=\"sensor_%d\"%s/>\n",
+             kind, i, (i * 37) % 320, (i * 53) % 240, 40 + i % 200, i % 16, i % 32,
+             i % 5 == 0 ? " text=\"Reading &amp; value\"" : "");
+    xml += line;
+  }
+  xml += "  </view>\n</component>\n";
+  return xml;
+}
+
+struct BenchConfig {
+  const char *name;
+  bool fresh;         // new document per parse, as LVML did before reusing them
+  size_t blockSize;   // node pool block size
+  size_t arenaSize;   // bump arena in front of the heap, 0 for none
+};
+
+static const BenchConfig kBenchConfigs[] = {
+  {"fresh doc, heap, 4K blocks", true, 4096, 0},
+  {"reused doc, heap, 4K blocks", false, 4096, 0},
+  {"reused doc, heap, 1K blocks", false, 1024, 0},
+  {"reused doc, heap, 16K blocks", false, 16384, 0},
+  {"reused doc, arena, 1K blocks", false, 1024, 4 << 20},
+};
+
+// Time and allocations per parse after one warm-up parse. "heap" counts
+// allocator calls that reached the heap, "doc" the pool blocks (heap or
+// arena) and text buffers the documents allocated.
+static void benchParse(const std::string &xml, int iterations, const BenchConfig &config) {
+  CountingAllocator heap;
+  std::vector<char> arenaMemory(config.arenaSize);
+  tinyxml2::XMLArena arena(config.arenaSize ? arenaMemory.data() : nullptr, config.arenaSize, &heap);
+  tinyxml2::XMLAllocator *allocator = config.arenaSize ? (tinyxml2::XMLAllocator *)&arena : &heap;
+
+  tinyxml2::XMLDocument reused;
+  reused.SetAllocator(allocator);
+  reused.SetBlockSize(config.blockSize);
+  reused.Parse(xml.data(), xml.size());
+  size_t heapBefore = heap.allocations;
+  size_t docBefore = reused.Allocations();
+  size_t docAllocations = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    if (config.fresh) {
+      tinyxml2::XMLDocument doc;
+      doc.SetAllocator(allocator);
+      doc.SetBlockSize(config.blockSize);
+      doc.Parse(xml.data(), xml.size());
+      docAllocations += doc.Allocations();
+    } else {
+      reused.Parse(xml.data(), xml.size());
+    }
+  }
+  double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  if (!config.fresh) {
+    docAllocations = reused.Allocations() - docBefore;
+  }
+
+  double perParse = micros / iterations;
+  printf("%-30s %9.1f us %7.1f MB/s %7.1f heap %7.1f doc\n", config.name, perParse, xml.size() / perParse,
+         (double)(heap.allocations - heapBefore) / iterations, (double)docAllocations / iterations);
+}
+
+struct LookupConfig {
+  const char *name;
+  size_t indexThreshold;  // hashed attribute index, 0 for none
+  bool nameTable;         // intern element and attribute names
+  bool internedKeys;      // look up with interned keys, as LVML does
+};
+
+static const LookupConfig kLookupConfigs[] = {
+  {"linear attribute lookup", 0, false, false},
+  {"attribute index >= 8", 8, false, false},
+  {"interned names", 0, true, false},
+  {"interned names and keys", 0, true, true},
+};
+
+// Parse time and lookup time over every attribute of every widget (plus one
+// miss each)
+static void benchAttributes(const std::string &xml, int iterations, const LookupConfig &config) {
+  static const char *keys[] = {"name", "x", "y", "width", "height", "style_bg_color", "style_radius",
+                               "style_pad_all", "style_text_color", "bind_value", "text", "hidden"};
+  tinyxml2::XMLNameTable names;
+  tinyxml2::XMLDocument doc;
+  doc.SetAttributeIndexThreshold(config.indexThreshold);
+  doc.SetNameTable(config.nameTable ? &names : nullptr);
+  doc.Parse(xml.data(), xml.size());
+
+  std::vector<const char *> lookupKeys;
+  for (const char *key : keys) {
+    lookupKeys.push_back(config.internedKeys ? names.Intern(key) : key);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    doc.Parse(xml.data(), xml.size());
+  }
+  double parseMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+  size_t found = 0;
+  size_t lookups = 0;
+  tinyxml2::XMLElement *view = doc.RootElement()->FirstChildElement("view");
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    for (tinyxml2::XMLElement *e = view->FirstChildElement(); e; e = e->NextSiblingElement()) {
+      for (const char *key : lookupKeys) {
+        found += e->Attribute(key) != nullptr;
+        lookups++;
+      }
+    }
+  }
+  double lookupMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%-30s %9.1f us %7.1f ns/lookup (%zu found)\n", config.name, parseMicros / iterations,
+         lookupMicros * 1000 / lookups, found / iterations);
+}
+
+// Long text, comments and deep indentation: the byte scanners' share of a
+// parse is largest on documents like this
+static std::string generateTextScreen(int widgets) {
+  std::string xml = "<component>\n  <view width=\"100%\" height=\"100%\" flex_flow=\"column\">\n";
+  for (int i = 0; i < widgets; i++) {
+    std::string indent(4 + (i % 8) * 4, ' ');
+    char line[512];
+    snprintf(line, sizeof(line),
+             "%s<!-- Paragraph %d of the help screen, shown when the device is unconfigured -->\n"
+             "%s<lv_label name=\"p%d\"\n%s          width=\"300\"\n%s          long_mode=\"wrap\">\n"
+             "%s  Hold the button for three seconds to reset the network settings &amp; reboot.\n"
+             "%s</lv_label>\n",
+             indent.c_str(), i, indent.c_str(), i, indent.c_str(), indent.c_str(), indent.c_str(),
+             indent.c_str());
+    xml += line;
+  }
+  xml += "  </view>\n</component>\n";
+  return xml;
+}
+
+// Parse and print throughput on a reused document, which is what the text,
+// name, whitespace and entity scanners decide once allocation is gone
+static void benchScan(const char *name, const std::string &xml, int iterations) {
+  tinyxml2::XMLDocument doc;
+  doc.Parse(xml.data(), xml.size());
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    doc.Parse(xml.data(), xml.size());
+  }
+  double parseMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+  size_t printed = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    tinyxml2::XMLPrinter printer;
+    doc.Print(&printer);
+    printed += printer.CStrSize();
+  }
+  double printMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%-30s %7.1f MB/s parse %7.1f MB/s print\n", name, xml.size() * iterations / parseMicros,
+         printed / printMicros);
+}
+
+// Cost of a log call on the caller's side: a deferred record, a call
+// filtered out by the level, and the formatting every Serial.printf did
+// before it could send anything. Formatting the records later is timed too.
+static void benchLog(int calls) {
+  static const char *const kUrl = "http://192.168.1.105:8866/step1.xml";
+  LVMLLog &log = LVMLLog::instance();
+  char line[LVML_LOG_MAX_LINE];
+  int length = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  double drainNs = 0;
+  for (int i = 0; i < calls; i++) {
+    LVML_LOGI("Bundle loaded: %s, %d bytes, %d image(s)", kUrl, 20480 + i, 3);
+    if ((i & 63) == 63) {
+      auto drainStart = std::chrono::steady_clock::now();
+      while (log.read(line, sizeof(line)) > 0) {}
+      drainNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - drainStart).count();
+    }
+  }
+  double deferredNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  log.setLevel(LVML_LOG_WARN);
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < calls; i++) {
+    LVML_LOGI("Bundle loaded: %s, %d bytes, %d image(s)", kUrl, 20480 + i, 3);
+  }
+  double filteredNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  log.setLevel(LVML_LOG_LEVEL);
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < calls; i++) {
+    length += snprintf(line, sizeof(line), "Bundle loaded: %s, %d bytes, %d image(s)\n", kUrl, 20480 + i, 3);
+  }
+  double formatNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%-30s %7.1f ns per call (%.1f ns to format later)\n", "log, deferred record",
+         (deferredNs - drainNs) / calls, drainNs / calls);
+  printf("%-30s %7.1f ns per call\n", "log, below the level", filteredNs / calls);
+  printf("%-30s %7.1f ns per call, then %.1f ms at 115200 baud\n", "log, formatted in place", formatNs / calls,
+         length / (double)calls * 10 / 115.2);
+}
+
+// Inflates the body in TCP segment sized pieces as they would arrive at
+// <mbits> Mbit/s (0 = all at once), like LVMLInflateStream does while the
+// body streams in. Returns the wall-clock time in microseconds.
+static double inflateStreamed(const std::string &packed, const std::string &expected, double mbits) {
+  const size_t kSegment = 1460;
+  std::string out(expected.size(), '\0');
+  z_stream stream = {};
+  inflateInit(&stream);
+  stream.next_out = (Bytef *)&out[0];
+  stream.avail_out = out.size();
+  int result = Z_OK;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t offset = 0; offset < packed.size() && result == Z_OK; offset += kSegment) {
+    size_t length = std::min(kSegment, packed.size() - offset);
+    if (mbits > 0) {
+      // Mbit/s is bits per microsecond
+      std::this_thread::sleep_until(start + std::chrono::microseconds((long)((offset + length) * 8 / mbits)));
+    }
+    stream.next_in = (Bytef *)&packed[offset];
+    stream.avail_in = length;
+    result = inflate(&stream, Z_NO_FLUSH);
+  }
+  double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  inflateEnd(&stream);
+  if (result != Z_STREAM_END || out != expected) fprintf(stderr, "inflate: output differs\n");
+  return us;
+}
+
+// Identity transfer against deflate plus inflate at a few link rates. The
+// identity time is the bytes on the wire alone; the deflate time is
+// measured with the inflater fed at the link rate, so it shows whether
+// inflating keeps up with the link.
+static void benchInflate(const std::string &xml, int iterations) {
+  uLongf packedSize = compressBound(xml.size());
+  std::string packed(packedSize, '\0');
+  compress2((Bytef *)&packed[0], &packedSize, (const Bytef *)xml.data(), xml.size(), Z_BEST_COMPRESSION);
+  packed.resize(packedSize);
+
+  double cpuUs = 0;
+  for (int i = 0; i < iterations; i++) {
+    cpuUs += inflateStreamed(packed, xml, 0);
+  }
+  cpuUs /= iterations;
+  printf("%-30s %7.1f us CPU    %5.1f%% of %zu bytes, %.1f MB/s\n", "inflate, unthrottled", cpuUs,
+         100.0 * packed.size() / xml.size(), xml.size(), xml.size() / cpuUs);
+
+  static const double kRates[] = {0.5, 2, 10, 40};
+  for (double mbits : kRates) {
+    double identityUs = xml.size() * 8 / mbits;
+    double deflateUs = inflateStreamed(packed, xml, mbits);
+    char label[48];
+    snprintf(label, sizeof(label), "inflate, %g Mbit/s link", mbits);
+    printf("%-30s %7.1f ms identity %7.1f ms deflate (%.1fx)\n", label, identityUs / 1000, deflateUs / 1000,
+           identityUs / deflateUs);
+  }
+}
+
+static void benchPipeline(const std::string &xml, int iterations);
+
+static int cmdBench(int argc, char **argv) {
+  int widgets = argc > 0 ? atoi(argv[0]) : 2000;
+  int iterations = argc > 1 ? atoi(argv[1]) : 200;
+  if (widgets <= 0 || iterations <= 0) return -1;
+
+  std::string xml = generateScreen(widgets);
+  printf("screen: %d widgets, %zu bytes, %d iterations\n", widgets, xml.size(), iterations);
+  for (const BenchConfig &config : kBenchConfigs) {
+    benchParse(xml, iterations, config);
+  }
+  for (const LookupConfig &config : kLookupConfigs) {
+    benchAttributes(xml, iterations, config);
+  }
+  benchScan("scan, widget screen", xml, iterations);
+  benchScan("scan, text screen", generateTextScreen(widgets), iterations);
+  benchLog(iterations * 1000);
+  benchInflate(xml, iterations);
+  benchPipeline(xml, iterations);
+  return 0;
+}
+
+//--------------------------------
+// mem
+//--------------------------------
+
+#if defined(__GLIBC__)
+// Allocator hook: glibc lets the program replace malloc and friends, and
+// operator new ends up here too
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static long gHeapInUse = 0;
+static long gHeapHighWater = 0;
+static long gHeapAllocations = 0;
+
+static void noteAlloc(void *ptr) {
+  if (!ptr) return;
+  gHeapAllocations++;
+  gHeapInUse += malloc_usable_size(ptr);
+  if (gHeapInUse > gHeapHighWater) gHeapHighWater = gHeapInUse;
+}
+
+extern "C" void *malloc(size_t size) {
+  void *ptr = __libc_malloc(size);
+  noteAlloc(ptr);
+  return ptr;
+}
+
+extern "C" void *calloc(size_t count, size_t size) {
+  void *ptr = __libc_calloc(count, size);
+  noteAlloc(ptr);
+  return ptr;
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+  if (ptr) gHeapInUse -= malloc_usable_size(ptr);
+  void *moved = __libc_realloc(ptr, size);
+  noteAlloc(moved ? moved : (size ? ptr : nullptr));
+  return moved;
+}
+
+extern "C" void free(void *ptr) {
+  if (ptr) gHeapInUse -= malloc_usable_size(ptr);
+  __libc_free(ptr);
+}
+
+static bool kHasAllocatorHook = true;
+#else
+static long gHeapInUse = 0;
+static long gHeapHighWater = 0;
+static long gHeapAllocations = 0;
+static bool kHasAllocatorHook = false;
+#endif
+
+// The host has one heap; it stands in for the device's internal RAM
+static LVMLMemoryUse hostInUse() {
+  return {(int32_t)gHeapInUse, 0, 0};
+}
+
+static LVMLMemoryUse hostHighWater() {
+  return {(int32_t)gHeapHighWater, 0, 0};
+}
+
+static uint32_t hostMicros() {
+  using namespace std::chrono;
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Allocations and bytes copied per screen load, after the body has arrived
+// in TCP segments. "Strings" replays the by-value pipeline LVMLBuffer
+// replaced: getString(), copies into loadScreenXml() and the rewrite,
+// Parse() into the document's own buffer, the printer's DynArray and the
+// String made from it. "buffer" is what LVML does now: a body buffer
+// sized from Content-Length, parsed in place and printed into the buffer
+// that is registered and kept.
+static void benchPipeline(const std::string &xml, int iterations) {
+  const size_t kSegment = 1460;
+  tinyxml2::XMLDocument doc;
+  long allocations[2] = {0, 0};
+  size_t copied[2] = {0, 0};
+
+  for (int i = 0; i < iterations; i++) {
+    long start = gHeapAllocations;
+    {
+      std::string body;
+      for (size_t offset = 0; offset < xml.size(); offset += kSegment) {
+        body.append(xml, offset, kSegment);
+      }
+      std::string screen = body;
+      std::string rewrite = screen;
+      doc.Parse(rewrite.c_str(), rewrite.size());
+      tinyxml2::XMLPrinter printer;
+      doc.Print(&printer);
+      std::string printed(printer.CStr());
+      std::string kept = printed;
+      copied[0] += screen.size() + rewrite.size() + rewrite.size() + printer.CStrSize() + printed.size() * 2;
+    }
+    allocations[0] += gHeapAllocations - start;
+
+    start = gHeapAllocations;
+    LVMLBuffer::resetStats();
+    {
+      LVMLBuffer body;
+      body.reserve(xml.size());
+      for (size_t offset = 0; offset < xml.size(); offset += kSegment) {
+        body.append(xml.data() + offset, std::min(kSegment, xml.size() - offset));
+      }
+      doc.ParseInSitu(body.data(), body.length());
+      LVMLBuffer printed;
+      LVMLBufferPrinter printer(printed);
+      doc.Print(&printer);
+      LVMLBuffer kept = std::move(printed);
+    }
+    allocations[1] += gHeapAllocations - start;
+    copied[1] += LVMLBuffer::bytesCopied();
+  }
+
+  static const char *const kNames[] = {"load pipeline, Strings", "load pipeline, buffer"};
+  for (int i = 0; i < 2; i++) {
+    if (kHasAllocatorHook) {
+      printf("%-30s %7.1f allocations %9.0f bytes copied per load\n", kNames[i],
+             allocations[i] / (double)iterations, copied[i] / (double)iterations);
+    } else {
+      printf("%-30s %9.0f bytes copied per load\n", kNames[i], copied[i] / (double)iterations);
+    }
+  }
+}
+
+// The device's steps up to registering the component: fetch the body,
+// parse it in place, rewrite and print it, then release it all when the
+// next screen replaces it. Widgets cannot be created on the host, so the
+// create phase stays unsampled, in memory and in LVMLMetrics.
+static bool measureScreen(const fs::path &screen, LVMLLoadMemory &load) {
+  LVML_TRACE_SCOPE("load_screen");
+  LVMLMetrics &metrics = LVMLMetrics::instance();
+  uint32_t start = hostMicros();
+  gHeapHighWater = gHeapInUse;
+  LVMLLoadTracker tracker;
+  tracker.begin(hostInUse(), hostHighWater());
+  bool ok = false;
+  {
+    std::string xml;
+    bool read;
+    {
+      LVML_TRACE_SCOPE("fetch_xml");
+      read = readFile(screen, xml);
+    }
+    uint32_t fetched = hostMicros();
+    if (read) {
+      metrics.load[LVML_STAGE_FETCH].observe(fetched - start);
+      tinyxml2::XMLDocument doc;
+      tinyxml2::XMLError result;
+      {
+        LVML_TRACE_SCOPE("parse");
+        result = doc.ParseInSitu(&xml[0], xml.size());
+      }
+      if (result == tinyxml2::XML_SUCCESS && doc.RootElement()) {
+        LVML_TRACE_SCOPE("print");
+        tinyxml2::XMLPrinter printer;
+        doc.Print(&printer);
+        tracker.sample(LVML_PHASE_PREPROCESS, hostInUse(), hostHighWater());
+        metrics.load[LVML_STAGE_PREPROCESS].observe(hostMicros() - fetched);
+        ok = true;
+      } else {
+        fprintf(stderr, "%s: %s\n", screen.c_str(), doc.ErrorStr());
+      }
+    } else {
+      fprintf(stderr, "%s: cannot read\n", screen.c_str());
+    }
+  }
+  tracker.sample(LVML_PHASE_RELEASE, hostInUse(), hostHighWater());
+  tracker.end(load);
+  if (ok) {
+    metrics.load[LVML_STAGE_TOTAL].observe(hostMicros() - start);
+    metrics.loadsOk++;
+  } else {
+    metrics.loadsFailed++;
+  }
+  return ok;
+}
+
+static int cmdMem(int argc, char **argv) {
+  if (argc < 1) return -1;
+  fs::path root = argv[0];
+  long maxPeak = 0;
+  std::vector<fs::path> screens;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--max-peak=", 11) == 0) {
+      maxPeak = atol(argv[i] + 11);
+    } else {
+      screens.push_back(argv[i]);
+    }
+  }
+  if (screens.empty()) screens = findScreens(root);
+  if (!kHasAllocatorHook) {
+    fprintf(stderr, "mem: no allocator hook on this platform\n");
+    return 1;
+  }
+
+  // Lazily initialized library state would show up as a leak of the first
+  // screen, so warm up once
+  LVMLLoadMemory warmUp;
+  if (!screens.empty()) measureScreen(screens[0], warmUp);
+
+  int errors = 0;
+  for (const fs::path &screen : screens) {
+    LVMLLoadMemory load;
+    if (!measureScreen(screen, load)) {
+      errors++;
+      continue;
+    }
+    char line[192];
+    LVMLLoadTracker::format(load, line, sizeof(line));
+    bool leaked = load.phase[LVML_PHASE_RELEASE].internal > 0;
+    bool over = maxPeak > 0 && load.peak.internal > maxPeak;
+    if (leaked || over) errors++;
+    printf("%-28s %s%s%s\n", serverPath(root, screen).c_str(), line,
+           over ? " OVER BUDGET" : "", leaked ? " LEAKED" : "");
+  }
+  return errors ? 1 : 0;
+}
+
+static int cmdTrace(int argc, char **argv) {
+  if (argc < 2) return -1;
+  fs::path root = argv[0];
+  fs::path out = argv[1];
+  std::vector<fs::path> screens(argv + 2, argv + argc);
+  if (screens.empty()) screens = findScreens(root);
+
+  int errors = 0;
+  for (const fs::path &screen : screens) {
+    LVMLLoadMemory load;
+    if (!measureScreen(screen, load)) errors++;
+  }
+  std::string json;
+  LVMLTrace::instance().exportJson([&json](const char *text) { json += text; });
+  if (!writeFile(out, json)) {
+    fprintf(stderr, "%s: cannot write\n", out.c_str());
+    return 1;
+  }
+  printf("%u span(s) of %d screen(s) written to %s\n", (unsigned)LVMLTrace::instance().recorded(),
+         (int)screens.size(), out.c_str());
+
+  // What a span costs when tracing is on; with it off there is no code
+  const int spans = 1000000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < spans; i++) {
+    LVML_TRACE_SCOPE("overhead");
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("span overhead: %.1f ns\n", ns / spans);
+  return errors ? 1 : 0;
+}
+
+//--------------------------------
+// metrics
+//--------------------------------
+
+// The firmware's exposition with the host's figures; the host heap stands
+// in for internal RAM as in mem
+static std::string metricsText() {
+  std::string text;
+  auto out = lvmlMetricsWriter([&text](const char *line) { text += line; });
+  lvmlWriteMetrics(out, LVMLMetrics::instance());
+  out.family("lvml_heap_used_bytes", "gauge", "Heap in use");
+  out.sample("lvml_heap_used_bytes", "region=\"internal\"", gHeapInUse);
+  out.family("lvml_heap_peak_bytes", "gauge", "Most heap in use since the last load started");
+  out.sample("lvml_heap_peak_bytes", "region=\"internal\"", gHeapHighWater);
+  return text;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Answers GET /metrics on 127.0.0.1 like the device does, one connection
+// at a time, until <scrapes> requests were served (0 = forever)
+static int serveMetrics(int port, int scrapes) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  sockaddr_in address = {};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (listener < 0 || bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 4) != 0) {
+    fprintf(stderr, "metrics: cannot listen on port %d\n", port);
+    if (listener >= 0) close(listener);
+    return 1;
+  }
+  printf("serving http://127.0.0.1:%d/metrics\n", port);
+  fflush(stdout);
+  for (int served = 0; scrapes == 0 || served < scrapes;) {
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0) continue;
+    std::string request;
+    char buffer[1024];
+    ssize_t received;
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           (received = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+      request.append(buffer, received);
+    }
+    std::string body, status;
+    if (request.compare(0, 13, "GET /metrics ") == 0) {
+      status = "200 OK";
+      body = metricsText();
+      served++;
+    } else {
+      status = "404 Not Found";
+      body = "Not found\n";
+    }
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: text/plain; version=0.0.4\r\n" +
+                           "Content-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    send(client, response.data(), response.size(), 0);
+    close(client);
+  }
+  close(listener);
+  return 0;
+}
+#else
+static int serveMetrics(int, int) {
+  fprintf(stderr, "metrics: --serve needs POSIX sockets\n");
+  return 1;
+}
+#endif
+
+static int cmdMetrics(int argc, char **argv) {
+  if (argc < 1) return -1;
+  fs::path root = argv[0];
+  int loads = 10;
+  int port = 0;
+  int scrapes = 0;
+  std::vector<fs::path> screens;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--loads=", 8) == 0) {
+      loads = atoi(argv[i] + 8);
+    } else if (strncmp(argv[i], "--serve=", 8) == 0) {
+      port = atoi(argv[i] + 8);
+    } else if (strncmp(argv[i], "--scrapes=", 10) == 0) {
+      scrapes = atoi(argv[i] + 10);
+    } else {
+      screens.push_back(argv[i]);
+    }
+  }
+  if (screens.empty()) screens = findScreens(root);
+
+  int errors = 0;
+  for (int i = 0; i < loads; i++) {
+    for (const fs::path &screen : screens) {
+      LVMLLoadMemory load;
+      if (!measureScreen(screen, load)) errors++;
+    }
+  }
+  if (port > 0) return (serveMetrics(port, scrapes) != 0 || errors) ? 1 : 0;
+  fputs(metricsText().c_str(), stdout);
+  return errors ? 1 : 0;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage:\n"
+          "  lvmlc bundle <root> [screen.xml...]\n"
+          "  lvmlc compile <root> [screen.xml...]\n"
+          "  lvmlc check <root> [screen.xml...]\n"
+          "  lvmlc minify <root> <out>\n"
+          "  lvmlc bench [widgets] [iterations]\n"
+          "  lvmlc mem <root> [--max-peak=<bytes>] [screen.xml...]\n"
+          "  lvmlc trace <root> <out.json> [screen.xml...]\n"
+          "  lvmlc metrics <root> [--loads=N] [--serve=<port>] [--scrapes=N] [screen.xml...]\n");
+}
+
+int main(int argc, char **argv) {
+  int result = -1;
+  try {
+    if (argc >= 2 && strcmp(argv[1], "bundle") == 0) {
+      result = cmdBundle(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "compile") == 0) {
+      result = cmdCompile(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "check") == 0) {
+      result = cmdCheck(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "minify") == 0) {
+      result = cmdMinify(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+      result = cmdBench(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "mem") == 0) {
+      result = cmdMem(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "trace") == 0) {
+      result = cmdTrace(argc - 2, argv + 2);
+    } else if (argc >= 2 && strcmp(argv[1], "metrics") == 0) {
+      result = cmdMetrics(argc - 2, argv + 2);
+    }
+  } catch (const fs::filesystem_error &e) {
+    // e.g. a screen file where a root directory is expected
+    fprintf(stderr, "%s\n", e.what());
+  }
+  if (result < 0) {
+    usage();
+    return 2;
+  }
+  return result;
+}